@@ -0,0 +1,225 @@
+#include "approxPeel.h"
+
+/**
+ * Approximately peels points into convex layers
+ * @param points Points to peel, must be unique
+ * @param epsilon Grid cell size as a fraction of the larger side of the bounding box of the points left for a layer
+ * @param depth Optional output, layer of every point in the order of points
+ * @param progress Optional counters advanced by the points of every layer
+ * @param cancel Optional token checked every layer, a cancelled run returns the layers found so far
+ * @return Coreset layers, per layer counts and bounds, and the achieved error
+ */
+ApproxPeelResult ApproxPeel::peel(const std::vector<Coordinate>& points, double epsilon, std::vector<int>* depth, Progress* progress, const CancelToken* cancel) {
+    ApproxPeelResult result;
+    if(points.empty() || epsilon <= 0){
+        return result;
+    }
+
+    if(depth != nullptr){
+        depth->assign(points.size(), 0);
+    }
+
+    auto cellsPerSide = (int)std::max(1.0, std::ceil(1.0 / epsilon));
+    const int none = -1;
+    std::vector<int> columnLow(cellsPerSide), columnHigh(cellsPerSide);
+    std::vector<int> rowLow(cellsPerSide), rowHigh(cellsPerSide);
+    std::vector<int> coresetIdx, hull, used;
+    std::vector<Coordinate> coreset, corners;
+
+    std::vector<int> remaining(points.size()), inside;
+    for(int p = 0; p < points.size(); p++){
+        remaining[p] = p;
+    }
+
+    if(progress != nullptr){
+        progress->begin("Points Peeled.", (long)points.size());
+    }
+
+    while(!remaining.empty()){
+        if(cancel != nullptr && cancel->isCancelled()){
+            break;
+        }
+
+        int minX = std::numeric_limits<int>::max(), minY = std::numeric_limits<int>::max();
+        int maxX = std::numeric_limits<int>::min(), maxY = std::numeric_limits<int>::min();
+        for(int p: remaining){
+            const Coordinate& c = points[p];
+            minX = std::min(minX, c.getX());
+            maxX = std::max(maxX, c.getX());
+            minY = std::min(minY, c.getY());
+            maxY = std::max(maxY, c.getY());
+        }
+
+        long extent = std::max((long)maxX - minX, (long)maxY - minY) + 1;
+        double cellSize = (double)extent / cellsPerSide;
+
+        // Lowest and highest point of every column, leftmost and rightmost of every row
+        std::fill(columnLow.begin(), columnLow.end(), none);
+        std::fill(columnHigh.begin(), columnHigh.end(), none);
+        std::fill(rowLow.begin(), rowLow.end(), none);
+        std::fill(rowHigh.begin(), rowHigh.end(), none);
+
+        for(int p: remaining){
+            const Coordinate& c = points[p];
+            int cx = std::min(cellsPerSide - 1, (int)((c.getX() - (long)minX) / cellSize));
+            int cy = std::min(cellsPerSide - 1, (int)((c.getY() - (long)minY) / cellSize));
+
+            if(columnLow[cx] == none || c.getY() < points[columnLow[cx]].getY()) columnLow[cx] = p;
+            if(columnHigh[cx] == none || c.getY() > points[columnHigh[cx]].getY()) columnHigh[cx] = p;
+            if(rowLow[cy] == none || c.getX() < points[rowLow[cy]].getX()) rowLow[cy] = p;
+            if(rowHigh[cy] == none || c.getX() > points[rowHigh[cy]].getX()) rowHigh[cy] = p;
+        }
+
+        coresetIdx.clear();
+        for(auto* picks: {&columnLow, &columnHigh, &rowLow, &rowHigh}){
+            for(int p: *picks){
+                if(p != none){
+                    coresetIdx.push_back(p);
+                }
+            }
+        }
+        std::sort(coresetIdx.begin(), coresetIdx.end());
+        coresetIdx.erase(std::unique(coresetIdx.begin(), coresetIdx.end()), coresetIdx.end());
+
+        coreset.clear();
+        for(int p: coresetIdx){
+            coreset.push_back(points[p]);
+        }
+        result.coresetSize += coreset.size();
+
+        // The hull of the extremes is within one cell of every point left, it is this layer's boundary
+        result.layers.emplace_back();
+        std::vector<Coordinate>& layer = result.layers.back();
+        corners.clear();
+        if(coreset.size() < 3){
+            layer = coreset;
+        }else{
+            ConvexHull::hullWalk(coreset, hull, used);
+            for(int idx: used){
+                layer.push_back(coreset[idx]);
+            }
+            for(int idx: hull){
+                corners.push_back(coreset[idx]);
+            }
+            corners = strictCorners(corners);
+        }
+
+        size_t layerIdx = result.layers.size() - 1;
+        result.layerCounts.push_back(0);
+        result.layerBounds.push_back(cellSize);
+
+        // Points strictly inside the boundary go on to the next layer, the rest belong to this one
+        inside.clear();
+        for(int p: remaining){
+            const Coordinate& q = points[p];
+            if(corners.size() >= 3 && contains(corners, q, true)){
+                inside.push_back(p);
+                continue;
+            }
+
+            result.layerCounts[layerIdx]++;
+            if(depth != nullptr){
+                (*depth)[p] = (int)layerIdx;
+            }
+            if(corners.size() >= 3 && !contains(corners, q, false)){
+                result.maxOutside = std::max(result.maxOutside, distanceOutside(corners, q));
+            }
+        }
+        remaining.swap(inside);
+
+        if(progress != nullptr){
+            progress->advance((long)result.layerCounts[layerIdx]);
+        }
+    }
+    if(progress != nullptr){
+        progress->finish();
+    }
+
+    return result;
+}
+
+/**
+ * Drops colinear points from a layer and orders it counter clockwise
+ */
+std::vector<Coordinate> ApproxPeel::strictCorners(const std::vector<Coordinate>& layer) {
+    std::vector<Coordinate> corners;
+    size_t m = layer.size();
+
+    for(size_t i = 0; i < m; i++){
+        if(cross(layer[(i + m - 1) % m], layer[i], layer[(i + 1) % m]) != 0){
+            corners.push_back(layer[i]);
+        }
+    }
+
+    long area = 0;
+    for(size_t i = 0; i < corners.size(); i++){
+        const Coordinate& a = corners[i];
+        const Coordinate& b = corners[(i + 1) % corners.size()];
+        area += (long)a.getX() * b.getY() - (long)b.getX() * a.getY();
+    }
+    if(area < 0){
+        std::reverse(corners.begin(), corners.end());
+    }
+
+    return corners;
+}
+
+/**
+ * Returns whether q lies inside a counter clockwise convex polygon, in O(log n)
+ * @param strict Whether points on the boundary count as outside
+ */
+bool ApproxPeel::contains(const std::vector<Coordinate>& polygon, const Coordinate& q, bool strict) {
+    size_t m = polygon.size();
+    if(m < 3){
+        return false;
+    }
+
+    // With strict corners, points strictly inside are strictly left of both edges at the origin
+    const Coordinate& origin = polygon[0];
+    long first = cross(origin, polygon[1], q), last = cross(origin, polygon[m - 1], q);
+    if(strict ? first <= 0 || last >= 0 : first < 0 || last > 0){
+        return false;
+    }
+
+    // Find the wedge from origin holding q
+    size_t lo = 1, hi = m - 1;
+    while(hi - lo > 1){
+        size_t mid = (lo + hi) / 2;
+        if(cross(origin, polygon[mid], q) >= 0){
+            lo = mid;
+        }else{
+            hi = mid;
+        }
+    }
+
+    long side = cross(polygon[lo], polygon[hi], q);
+    return strict ? side > 0 : side >= 0;
+}
+
+/**
+ * Returns the distance from q to the nearest edge of a polygon
+ */
+double ApproxPeel::distanceOutside(const std::vector<Coordinate>& polygon, const Coordinate& q) {
+    double best = std::numeric_limits<double>::max();
+
+    for(size_t i = 0; i < polygon.size(); i++){
+        const Coordinate& a = polygon[i];
+        const Coordinate& b = polygon[(i + 1) % polygon.size()];
+
+        double dx = b.getX() - a.getX(), dy = b.getY() - a.getY();
+        double t = ((q.getX() - a.getX()) * dx + (q.getY() - a.getY()) * dy) / (dx * dx + dy * dy);
+        t = std::max(0.0, std::min(1.0, t));
+
+        double ex = a.getX() + t * dx - q.getX(), ey = a.getY() + t * dy - q.getY();
+        best = std::min(best, std::sqrt(ex * ex + ey * ey));
+    }
+
+    return best;
+}
+
+/**
+ * Cross product of (a - o) and (b - o), positive when o, a, b turn counter clockwise
+ */
+long ApproxPeel::cross(const Coordinate& o, const Coordinate& a, const Coordinate& b) {
+    return ((long)a.getX() - o.getX()) * ((long)b.getY() - o.getY()) - ((long)a.getY() - o.getY()) * ((long)b.getX() - o.getX());
+}
@@ -0,0 +1,38 @@
+#ifndef APPROX_PEEL_H
+#define APPROX_PEEL_H
+
+#include <vector>
+#include "convexHull.h"
+
+/**
+ * Result of ApproxPeel::peel
+ */
+struct ApproxPeelResult {
+    std::vector<std::vector<Coordinate>> layers; // Boundary of every layer, outermost first, in hull order
+    std::vector<size_t> layerCounts;             // Number of input points assigned to each layer
+    std::vector<double> layerBounds;             // Every point of a layer lies within this distance of its boundary
+    size_t coresetSize = 0;                      // Extreme points taken over all layers
+    double maxOutside = 0;                       // Farthest a point lies outside the boundary of its layer
+};
+
+/**
+ * ε-approximate convex layers. Every layer is found from a coreset of the extreme points of every
+ * column and row of a grid of 1/ε cells per side over the points not yet peeled, at most 4/ε points.
+ * The hull of the coreset is the layer's boundary and is within one cell of every point left, the
+ * points not strictly inside it form the layer. A layer always takes the true hull of the points left
+ * and possibly more, so no point is assigned a layer deeper than its exact convex layer.
+ * Runs in O(L (n log(1/ε) + 1/ε²)) time for L layers and O(1/ε) extra memory besides the point indices.
+ */
+class ApproxPeel {
+public:
+    static ApproxPeelResult peel(const std::vector<Coordinate>& points, double epsilon, std::vector<int>* depth = nullptr,
+                                 Progress* progress = nullptr, const CancelToken* cancel = nullptr);
+private:
+    static std::vector<Coordinate> strictCorners(const std::vector<Coordinate>& layer);
+    static bool contains(const std::vector<Coordinate>& polygon, const Coordinate& q, bool strict);
+    static double distanceOutside(const std::vector<Coordinate>& polygon, const Coordinate& q);
+    static long cross(const Coordinate& o, const Coordinate& a, const Coordinate& b);
+};
+
+
+#endif //APPROX_PEEL_H
@@ -0,0 +1,21 @@
+#ifndef CANVAS_H
+#define CANVAS_H
+
+
+/**
+ * Surface the hull algorithms draw onto. Implemented by GlImage for the window
+ * and by TiledImage for canvases too large to hold densely.
+ */
+class Canvas {
+public:
+    virtual ~Canvas() = default;
+    virtual void setPixel(int x, int y, int r, int g, int b) = 0;
+    virtual void setSpan(int x, int y, int len, int r, int g, int b) = 0;
+    virtual void clear() = 0;
+    virtual int getHeight() = 0;
+    virtual int getWidth() = 0;
+    virtual void publish(bool force = false) {}
+};
+
+
+#endif //CANVAS_H
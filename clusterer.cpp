@@ -0,0 +1,69 @@
+#include "clusterer.h"
+#include "kMeans.h"
+
+/**
+ * Groups the data by the cluster each point is assigned
+ * @param data Data Points
+ * @param k K groups
+ * @param rng Random generator for methods that need one
+ * @return List of grouped data
+ */
+std::vector<std::vector<Coordinate>> Clusterer::group(const std::vector<Coordinate>& data, int k, std::mt19937& rng) {
+    std::vector<int> assignments = assign(data, k, rng);
+
+    std::vector<std::vector<Coordinate>> groupedData(k);
+    for(int p = 0; p < data.size(); p++){
+        groupedData[assignments[p]].push_back(data[p]);
+    }
+
+    return groupedData;
+}
+
+/**
+ * Returns a string identifying the method and its parameters, for caching results
+ */
+std::string Clusterer::getKey() {
+    return getName();
+}
+
+/**
+ * Sets the counters to report progress on and the token to check for cancellation, either may be null
+ */
+void Clusterer::setMonitor(Progress* progress, const CancelToken* cancel) {
+    this->progress = progress;
+    this->cancel = cancel;
+}
+
+KMeansClusterer::KMeansClusterer(int nIterations) {
+    this->nIterations = nIterations;
+}
+
+std::vector<int> KMeansClusterer::assign(const std::vector<Coordinate>& data, int k, std::mt19937& rng) {
+    // The warm start only applies to the next run
+    this->centroids.swap(this->startCentroids);
+    this->startCentroids.clear();
+
+    return KMeans::assign(data, k, this->nIterations, rng, &this->centroids, this->progress, this->cancel);
+}
+
+std::string KMeansClusterer::getName() {
+    return "k-means";
+}
+
+std::string KMeansClusterer::getKey() {
+    return getName() + "/" + std::to_string(this->nIterations);
+}
+
+/**
+ * Sets the centroids the next assign starts from instead of random points
+ */
+void KMeansClusterer::setCentroids(const std::vector<Coordinate>& start) {
+    this->startCentroids = start;
+}
+
+/**
+ * Returns the centroids the last assign converged to
+ */
+std::vector<Coordinate> KMeansClusterer::getCentroids() {
+    return this->centroids;
+}
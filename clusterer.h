@@ -0,0 +1,45 @@
+#ifndef CLUSTERER_H
+#define CLUSTERER_H
+
+#include <vector>
+#include <string>
+#include <random>
+#include "coordinate.h"
+#include "progress.h"
+
+/**
+ * Splits a point set into k groups. clusterPeels dispatches through this so the
+ * grouping method can be swapped.
+ */
+class Clusterer {
+public:
+    virtual ~Clusterer() = default;
+    virtual std::vector<int> assign(const std::vector<Coordinate>& data, int k, std::mt19937& rng) = 0;
+    virtual std::string getName() = 0;
+    virtual std::string getKey();
+    std::vector<std::vector<Coordinate>> group(const std::vector<Coordinate>& data, int k, std::mt19937& rng);
+    void setMonitor(Progress* progress, const CancelToken* cancel);
+protected:
+    Progress* progress = nullptr;
+    const CancelToken* cancel = nullptr;
+};
+
+/**
+ * Exact k-means clustering, see KMeans. Can be warm started from the centroids of an earlier run.
+ */
+class KMeansClusterer : public Clusterer {
+public:
+    explicit KMeansClusterer(int nIterations);
+    std::vector<int> assign(const std::vector<Coordinate>& data, int k, std::mt19937& rng) override;
+    std::string getName() override;
+    std::string getKey() override;
+    void setCentroids(const std::vector<Coordinate>& start);
+    std::vector<Coordinate> getCentroids();
+private:
+    int nIterations;
+    std::vector<Coordinate> startCentroids;
+    std::vector<Coordinate> centroids;
+};
+
+
+#endif //CLUSTERER_H
@@ -1,62 +1,177 @@
 #include "convexHull.h"
+#include "approxPeel.h"
+#include <sstream>
 
-ConvexHull::ConvexHull(GlImage *img, int imgWidth, int imgHeight, int nRanPoints, int kClusters, ulong seed) {
+ConvexHull::ConvexHull(Canvas *img, int nRanPoints, int kClusters, ulong seed) {
     this->img = img;
     this->nRanPoints = nRanPoints;
     this->kClusters = kClusters;
+    this->clusterer.reset(new KMeansClusterer(MAX_ITERATIONS));
+    this->clusterer->setMonitor(&progress, &cancelToken);
 
     rng = std::mt19937(seed);
 
-    initImg(imgWidth, imgHeight);
     generatePoints();
 }
 
 /**
- * Removes a coordinate from a vector
- * @param vec Pointer to vector to modify
- * @param c Coordinate to remove
+ * Applies a convex peel to the convPoints specified
+ * @param convPoints Points to peel
+ * @param r R channel
+ * @param g G channel
+ * @param b B channel
  */
-void ConvexHull::removeFromVector(std::vector<Coordinate> *vec, Coordinate c) {
-    for(int i = 0; i < vec->size(); i++){
-        if((*vec)[i].equal(c)){
-            vec->erase(vec->begin() + i);
-            return;
-        }
+void ConvexHull::convPeel(const std::vector<Coordinate>& convPoints, int r, int g, int b) {
+    if(convPoints.size() < 3){
+        std::cout << "Not enough convPoints. Generate some convPoints" << std::endl;
+        return;
     }
+
+    progress.begin("Points Peeled.", (long)convPoints.size());
+    peelCluster(convPoints, r, g, b);
+    progress.finish();
 }
 
 /**
- * Applies a convex peel to the convPoints specified
+ * Peels and draws one set of points, from the cache if it was peeled before
  * @param convPoints Points to peel
  * @param r R channel
  * @param g G channel
  * @param b B channel
  */
-void ConvexHull::convPeel(const std::vector<Coordinate>& convPoints, int r, int g, int b) {
-    if(convPoints.size() < 3){
-        std::cout << "Not enough convPoints. Generate some convPoints" << std::endl;
+void ConvexHull::peelCluster(const std::vector<Coordinate>& convPoints, int r, int g, int b) {
+    std::vector<std::vector<Coordinate>> layers;
+    uint64_t members = ResultCache::membership(convPoints);
+
+    if(cache.findLayers(members, layers)){
+        for(auto& layer: layers){
+            if(isCancelled()){
+                return;
+            }
+            drawLayer(layer, r, g, b);
+            progress.advance((long)layer.size());
+            img->publish();
+        }
         return;
     }
 
-    std::vector<Coordinate> workPoints;
+    PeelBuffers buffers;
+    peelLayers(convPoints, layers, buffers, [&](const std::vector<Coordinate>& layer){
+        drawLayer(layer, r, g, b);
+        progress.advance((long)layer.size());
+        img->publish();
+        return !isCancelled();
+    });
 
-    workPoints.reserve(convPoints.size());
-    for (Coordinate point : convPoints) {
-        workPoints.emplace_back(point.getX(), point.getY());
+    if(!isCancelled()){
+        cache.storeLayers(members, layers);
     }
+}
 
-    while(workPoints.size() > 2){
+/**
+ * Draws ε-approximate convex layers of the points and reports the error achieved
+ * @param epsilon Grid cell size as a fraction of the point set's extent
+ * @param r R channel
+ * @param g G channel
+ * @param b B channel
+ */
+void ConvexHull::approxPeel(double epsilon, int r, int g, int b) {
+    if(points.size() < 3){
+        std::cout << "Not enough points. Generate some points" << std::endl;
+        return;
+    }
 
-        std::vector<Coordinate> verticesToRemove = convHull(workPoints, r, g, b);
+    ApproxPeelResult result = ApproxPeel::peel(points, epsilon, nullptr, &progress, &cancelToken);
 
-        for(Coordinate c: verticesToRemove){
-            removeFromVector(&workPoints, c);
+    for(auto& layer: result.layers){
+        if(isCancelled()){
+            return;
         }
+        drawLayer(layer, r, g, b);
+        img->publish();
+    }
+
+    // Printed through the progress reporter so it cannot land in the middle of a progress line
+    std::ostringstream summary;
+    summary << "Approximate peel: " << result.layers.size() << " layers of " << points.size() << " points, hulling " << result.coresetSize << " grid extremes in total.";
+    progress.note(summary.str());
+
+    summary.str("");
+    summary << "Farthest point outside the boundary of its layer " << result.maxOutside << ".";
+    progress.note(summary.str());
+
+    summary.str("");
+    summary << "Points per layer, outermost first:";
+    for(size_t count: result.layerCounts){
+        summary << " " << count;
     }
+    progress.note(summary.str());
+
+    summary.str("");
+    summary << "Distance bound per layer, outermost first:";
+    for(double bound: result.layerBounds){
+        summary << " " << bound;
+    }
+    progress.note(summary.str());
 }
 
 /**
- * Applies k-means clustering to the list of points
+ * Peels convPoints into convex layers without drawing them.
+ * Every point ends up in exactly one layer, points left over once fewer than 3 remain form the last layer.
+ * Points must be unique.
+ * @param convPoints Points to peel
+ * @param layers Output, outermost layer first, each in hull order
+ * @param buffers Scratch space reused between calls
+ * @param onLayer Called with every layer as it is found, peeling stops if it returns false
+ */
+void ConvexHull::peelLayers(const std::vector<Coordinate>& convPoints, std::vector<std::vector<Coordinate>>& layers, PeelBuffers& buffers,
+                            const std::function<bool(const std::vector<Coordinate>&)>& onLayer) {
+    std::vector<Coordinate>& workPoints = buffers.work;
+    workPoints.assign(convPoints.begin(), convPoints.end());
+
+    // Layer vectors are kept across calls so their storage is reused
+    size_t nLayers = 0;
+
+    while(!workPoints.empty()){
+        if(nLayers == layers.size()){
+            layers.emplace_back();
+        }
+        std::vector<Coordinate>& layer = layers[nLayers++];
+        layer.clear();
+
+        if(workPoints.size() < 3){
+            layer.assign(workPoints.begin(), workPoints.end());
+            break;
+        }
+
+        hullWalk(workPoints, buffers.hull, buffers.used);
+
+        buffers.removed.assign(workPoints.size(), 0);
+        for(int idx: buffers.used){
+            if(!buffers.removed[idx]){
+                buffers.removed[idx] = 1;
+                layer.push_back(workPoints[idx]);
+            }
+        }
+
+        buffers.next.clear();
+        for(size_t p = 0; p < workPoints.size(); p++){
+            if(!buffers.removed[p]){
+                buffers.next.push_back(workPoints[p]);
+            }
+        }
+        workPoints.swap(buffers.next);
+
+        if(onLayer && !onLayer(layer)){
+            break;
+        }
+    }
+
+    layers.resize(nLayers);
+}
+
+/**
+ * Clusters the list of points with the current clusterer and peels every cluster
  */
 void ConvexHull::clusterPeels() {
     if(points.size() < 3){
@@ -64,8 +179,30 @@ void ConvexHull::clusterPeels() {
         return;
     }
 
-    //K-means clustering algorithm applied to points
-    std::vector<std::vector<Coordinate>> clusters = KMeans::group(points, kClusters, MAX_ITERATIONS, rng);
+    // Clusterings are seeded per point set so repeating one gives the same result and hits the cache
+    ResultCache::ClusterKey key{ResultCache::fingerprint(points), kClusters, clusterSeed, clusterer->getKey()};
+    std::vector<std::vector<Coordinate>> clusters;
+
+    if(!cache.findClusters(key, clusters)){
+        auto* kMeans = dynamic_cast<KMeansClusterer*>(clusterer.get());
+        std::vector<Coordinate> centroids;
+        if(kMeans != nullptr && cache.findCentroids(key.points, centroids)){
+            kMeans->setCentroids(centroids);
+        }
+
+        std::mt19937 clusterRng(clusterSeed);
+        clusters = clusterer->group(points, kClusters, clusterRng);
+        if(isCancelled()){
+            return;
+        }
+
+        if(kMeans != nullptr){
+            cache.storeCentroids(key.points, kMeans->getCentroids());
+        }
+        cache.storeClusters(key, clusters);
+    }
+
+    progress.begin("Points Peeled.", (long)points.size());
 
     uint nCores = std::thread::hardware_concurrency();
 
@@ -80,6 +217,8 @@ void ConvexHull::clusterPeels() {
     for (auto& future : futures) {
         future.wait();
     }
+
+    progress.finish();
 }
 
 /**
@@ -91,7 +230,33 @@ void ConvexHull::clusterPeels() {
  * @return List of convPoints used in the hull
  */
 std::vector<Coordinate> ConvexHull::convHull(std::vector<Coordinate> convPoints, int r, int g, int b) {
+    std::vector<int> hull, used;
+    hullWalk(convPoints, hull, used);
+
+    for(size_t h = 0; h < hull.size(); h++){
+        Coordinate& begin = convPoints[hull[h]];
+        Coordinate& end = convPoints[hull[(h + 1) % hull.size()]];
+        wuLine(begin.getX(), begin.getY(), end.getX(), end.getY(), r, g, b);
+    }
+
     std::vector<Coordinate> verticesUsed;
+    verticesUsed.reserve(used.size());
+    for(int idx: used){
+        verticesUsed.push_back(convPoints[idx]);
+    }
+
+    return sortCoords(verticesUsed);
+}
+
+/**
+ * Gift wraps convPoints, starting from the lowest left point
+ * @param convPoints Points to hull
+ * @param hull Output, indices of the hull corners in hull order
+ * @param used Output, indices of every point on the hull boundary in hull order, corners and colinear points
+ */
+void ConvexHull::hullWalk(const std::vector<Coordinate>& convPoints, std::vector<int>& hull, std::vector<int>& used) {
+    hull.clear();
+    used.clear();
 
     int minX = std::numeric_limits<int>::max(), minY = std::numeric_limits<int>::max();
     int minCoord = -1;
@@ -109,36 +274,55 @@ std::vector<Coordinate> ConvexHull::convHull(std::vector<Coordinate> convPoints,
 
     do{
         j = (int)((i+1) % convPoints.size());
-        std::vector<Coordinate> colinearPoints;
+
+        hull.push_back(i);
+        used.push_back(i);
+        size_t edgeStart = used.size();
 
         for(int k = 0; k < convPoints.size(); k++){
-            int dis = fastOrientation(convPoints[i], convPoints[k], convPoints[j]);
+            long dis = fastOrientation(convPoints[i], convPoints[k], convPoints[j]);
 
-            if(dis < 0){ //The edge is counter clockwise
+            if(dis < 0){ //The edge is counter clockwise, points colinear with the old edge are not on the hull
                 j = k;
+                used.resize(edgeStart);
             }else if(dis == 0 && i != k && k != j){// colinear
                 if(sqDis(convPoints[i], convPoints[j]) < sqDis(convPoints[i], convPoints[k])){
-                    colinearPoints.push_back(convPoints[j]);
+                    used.push_back(j);
                     j = k;
                 }else{
-                    colinearPoints.push_back(convPoints[k]);
+                    used.push_back(k);
                 }
             }
         }
 
-        verticesUsed.emplace_back(convPoints[i].getX(), convPoints[i].getY());
-
-        for(Coordinate c: colinearPoints){
-            verticesUsed.emplace_back(c.getX(), c.getY());
-        }
-
-        wuLine(convPoints[i].getX(), convPoints[i].getY(), convPoints[j].getX(), convPoints[j].getY(), r , g, b);
+        // Keep colinear points in the order they are passed along the edge
+        const Coordinate& begin = convPoints[i];
+        std::sort(used.begin() + edgeStart, used.end(), [&](int a, int b){
+            return sqDis(begin, convPoints[a]) < sqDis(begin, convPoints[b]);
+        });
 
         i = j;
 
     }while(i != minCoord);
+}
 
-    return sortCoords(verticesUsed);
+/**
+ * Draws the closed polygon through the points of a layer
+ * @param layer Points in hull order
+ * @param r R channel
+ * @param g G channel
+ * @param b B channel
+ */
+void ConvexHull::drawLayer(const std::vector<Coordinate>& layer, int r, int g, int b) {
+    if(layer.size() < 3){
+        return;
+    }
+
+    for(size_t p = 0; p < layer.size(); p++){
+        const Coordinate& begin = layer[p];
+        const Coordinate& end = layer[(p + 1) % layer.size()];
+        wuLine(begin.getX(), begin.getY(), end.getX(), end.getY(), r, g, b);
+    }
 }
 
 /**
@@ -179,7 +363,7 @@ bool ConvexHull::less(Coordinate a, Coordinate b) {
     }
 
     // compute the cross product of vectors (center -> a) x (center -> b)
-    int det = (a.getX() - center.getX()) * (b.getY() - center.getY()) - (b.getX() - center.getX()) * (a.getY() - center.getY());
+    long det = ((long)a.getX() - center.getX()) * ((long)b.getY() - center.getY()) - ((long)b.getX() - center.getX()) * ((long)a.getY() - center.getY());
     if (det < 0)
         return true;
     if (det > 0)
@@ -187,8 +371,8 @@ bool ConvexHull::less(Coordinate a, Coordinate b) {
 
     // points a and b are on the same line from the center
     // check which point is closer to the center
-    int d1 = (a.getX() - center.getX()) * (a.getX() - center.getX()) + (a.getY() - center.getY()) * (a.getY() - center.getY());
-    int d2 = (b.getX() - center.getX()) * (b.getX() - center.getX()) + (b.getY() - center.getY()) * (b.getY() - center.getY());
+    long d1 = ((long)a.getX() - center.getX()) * ((long)a.getX() - center.getX()) + ((long)a.getY() - center.getY()) * ((long)a.getY() - center.getY());
+    long d2 = ((long)b.getX() - center.getX()) * ((long)b.getX() - center.getX()) + ((long)b.getY() - center.getY()) * ((long)b.getY() - center.getY());
     return d1 > d2;
 }
 
@@ -198,8 +382,8 @@ bool ConvexHull::less(Coordinate a, Coordinate b) {
  * @param end  Point two
  * @return Squared Distance
  */
-int ConvexHull::sqDis(Coordinate begin, Coordinate end) {
-    return (begin.getY() - end.getY())*(begin.getY() - end.getY()) + (begin.getX() - end.getX())*(begin.getX() - end.getX());
+long ConvexHull::sqDis(Coordinate begin, Coordinate end) {
+    return ((long)begin.getY() - end.getY())*((long)begin.getY() - end.getY()) + ((long)begin.getX() - end.getX())*((long)begin.getX() - end.getX());
 }
 
 /**
@@ -209,8 +393,8 @@ int ConvexHull::sqDis(Coordinate begin, Coordinate end) {
  * @param end  Point three
  * @return 0 if the three points are co-linear or a positive or negative number otherwise
  */
-int ConvexHull::fastOrientation(Coordinate begin, Coordinate mid, Coordinate end) {
-    return ((mid.getY() - begin.getY()) * (end.getX() - mid.getX())) - ((mid.getX() - begin.getX()) * (end.getY() - mid.getY()));
+long ConvexHull::fastOrientation(Coordinate begin, Coordinate mid, Coordinate end) {
+    return (((long)mid.getY() - begin.getY()) * ((long)end.getX() - mid.getX())) - (((long)mid.getX() - begin.getX()) * ((long)end.getY() - mid.getY()));
 }
 
 /**
@@ -320,50 +504,108 @@ double ConvexHull::getFrac(double x){
  * n is specified on program startup
  */
 void ConvexHull::generatePoints() {
-    points.clear();
-    initImg(img->getWidth(), img->getHeight());
+    img->clear();
 
-    std::uniform_int_distribution<int> distH(1, img->getHeight()-1);
-    std::uniform_int_distribution<int> distW(1, img->getWidth()-1);
+    progress.begin("Created.", nRanPoints);
+
+    std::unordered_set<long> usedPoints;
+    randomPoints(nRanPoints, img->getWidth(), img->getHeight(), rng, points, usedPoints, &progress);
+    clusterSeed = rng();
+
+    for(Coordinate& c: points){
+        img->setPixel(c.getX(), c.getY(), 255, 255, 255);
+    }
+    progress.finish();
+
+    img->publish(true);
+}
+
+/**
+ * Creates n unique random points inside a w by h area, leaving a one pixel border
+ * @param n Number of points
+ * @param w Width of the area
+ * @param h Height of the area
+ * @param rng Random generator
+ * @param out Output, replaced with the points
+ * @param used Scratch set of taken locations, reused between calls
+ * @param progress Optional counters advanced every PROGRESS_BATCH points
+ */
+void ConvexHull::randomPoints(int n, int w, int h, std::mt19937& rng, std::vector<Coordinate>& out, std::unordered_set<long>& used,
+                              Progress* progress) {
+    out.clear();
+    used.clear();
 
-    std::unordered_map<int, int> usedPoints;
+    std::uniform_int_distribution<int> distH(1, h-1);
+    std::uniform_int_distribution<int> distW(1, w-1);
 
-    for(int i = 0; i < nRanPoints; i++){
+    while(out.size() < n){
         int xLoc = distW(rng);
         int yLoc = distH(rng);
 
-        if(usedPoints.find((yLoc*img->getWidth())+xLoc) != usedPoints.end()){
-            i--;
-            continue;
+        if(used.insert((long)yLoc * w + xLoc).second){
+            out.emplace_back(xLoc, yLoc);
+
+            if(progress != nullptr && out.size() % PROGRESS_BATCH == 0){
+                progress->advance(PROGRESS_BATCH);
+            }
         }
+    }
 
-        img->setPixel(xLoc, yLoc, 255, 255, 255);
+    if(progress != nullptr){
+        progress->advance((long)(out.size() % PROGRESS_BATCH));
+    }
+}
 
-        points.emplace_back(xLoc, yLoc);
-        usedPoints.insert({(yLoc*img->getWidth())+xLoc, 0});
+std::vector<Coordinate> ConvexHull::getAllPoints() {
+    return this->points;
+}
 
-        std::cout << "\r" << i+1 << "/" << nRanPoints << " Created." << std::flush;
-    }
-    std::cout << std::endl;
+/**
+ * Replaces the method clusterPeels groups points with
+ */
+void ConvexHull::setClusterer(std::unique_ptr<Clusterer> clusterer) {
+    this->clusterer = std::move(clusterer);
+    this->clusterer->setMonitor(&progress, &cancelToken);
+}
 
-    glutPostRedisplay();
+Clusterer* ConvexHull::getClusterer() {
+    return this->clusterer.get();
 }
 
 /**
- * Initializes the image black
- * @param w Width of image
- * @param h Height of image
+ * Sets the number of clusters clusterPeels groups points into
  */
-void ConvexHull::initImg(int w, int h) {
-    for(int y = 0; y < h; y++){
-        for(int x = 0; x < w; x++){
-            img->setPixel(x, y, 0, 0, 0);
-        }
-    }
+void ConvexHull::setClusters(int k) {
+    this->kClusters = k;
 }
 
-std::vector<Coordinate> ConvexHull::getAllPoints() {
-    return this->points;
+int ConvexHull::getClusters() {
+    return this->kClusters;
+}
+
+/**
+ * Requests that the running job stops at the next layer, iteration or cluster boundary
+ */
+void ConvexHull::cancel() {
+    cancelToken.cancel();
+}
+
+/**
+ * Clears a previous cancel request so a new job can run
+ */
+void ConvexHull::clearCancel() {
+    cancelToken.reset();
+}
+
+bool ConvexHull::isCancelled() {
+    return cancelToken.isCancelled();
+}
+
+/**
+ * Returns the counters the running job updates, for a ProgressReporter to print
+ */
+Progress& ConvexHull::getProgress() {
+    return this->progress;
 }
 
 template<typename T>
@@ -404,6 +646,10 @@ std::vector<std::vector<T>> ConvexHull::group(std::vector<T> items, uint nGroups
 
 void ConvexHull::processClustersAsync(const std::vector<std::vector<Coordinate>>& clusters) {
     for(auto &cluster: clusters){
+        if(isCancelled()){
+            return;
+        }
+
         std::uniform_int_distribution<int> dist(0, 255);
 
         int r = dist(rng), g = dist(rng), b = dist(rng);
@@ -421,6 +667,6 @@ void ConvexHull::processClustersAsync(const std::vector<std::vector<Coordinate>>
             }
         }
 
-        convPeel(cluster, r, g, b);
+        peelCluster(cluster, r, g, b);
     }
 }
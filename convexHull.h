@@ -2,47 +2,87 @@
 #define CONVEX_HULL_H
 
 
-#include "glImage.h"
+#include "canvas.h"
 #include "coordinate.h"
 #include "kMeans.h"
+#include "clusterer.h"
+#include "resultCache.h"
+#include "progress.h"
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <future>
+#include <cmath>
+#include <functional>
+#include <algorithm>
+#include <memory>
+#include <atomic>
 
 #define MAX_ITERATIONS 500
 #define DELTA_START 0
 #define DELTA_END 0
+#define PROGRESS_BATCH 4096
+
+/**
+ * Scratch space for ConvexHull::peelLayers, reused between calls to avoid reallocating
+ */
+struct PeelBuffers {
+    std::vector<Coordinate> work;
+    std::vector<Coordinate> next;
+    std::vector<int> hull;
+    std::vector<int> used;
+    std::vector<char> removed;
+};
 
 class ConvexHull {
 public:
-    ConvexHull(GlImage* img, int imgWidth, int imgHeight, int nRanPoints, int kClusters, ulong seed);
+    ConvexHull(Canvas* img, int nRanPoints, int kClusters, ulong seed);
 
 public:
     void convPeel(const std::vector<Coordinate>& convPoints, int r = 255, int g = 255, int b = 255);
     std::vector<Coordinate> convHull(std::vector<Coordinate> convPoints, int r = 255, int g = 255, int b = 255);
     void clusterPeels();
+    void approxPeel(double epsilon, int r = 255, int g = 255, int b = 255);
     void generatePoints();
     std::vector<Coordinate> getAllPoints();
+    void setClusterer(std::unique_ptr<Clusterer> clusterer);
+    void setClusters(int k);
+    int getClusters();
+    Clusterer* getClusterer();
+    void cancel();
+    void clearCancel();
+    bool isCancelled();
+    Progress& getProgress();
+    static void randomPoints(int n, int w, int h, std::mt19937& rng, std::vector<Coordinate>& out, std::unordered_set<long>& used,
+                             Progress* progress = nullptr);
+    static void hullWalk(const std::vector<Coordinate>& convPoints, std::vector<int>& hull, std::vector<int>& used);
+    static void peelLayers(const std::vector<Coordinate>& convPoints, std::vector<std::vector<Coordinate>>& layers, PeelBuffers& buffers,
+                           const std::function<bool(const std::vector<Coordinate>&)>& onLayer = nullptr);
 
 private:
-    static void removeFromVector(std::vector<Coordinate> *vec, Coordinate c);
+    void peelCluster(const std::vector<Coordinate>& convPoints, int r, int g, int b);
+    void drawLayer(const std::vector<Coordinate>& layer, int r, int g, int b);
     std::vector<Coordinate> sortCoords(std::vector<Coordinate> list);
     bool less(Coordinate a, Coordinate b);
-    static int sqDis(Coordinate begin, Coordinate end);
-    static int fastOrientation(Coordinate begin, Coordinate mid, Coordinate end);
+    static long sqDis(Coordinate begin, Coordinate end);
+    static long fastOrientation(Coordinate begin, Coordinate mid, Coordinate end);
     void wuLine(int x1, int y1, int x2, int y2, int r, int g, int b);
     static double getRemainder(double x);
     static double getFrac(double x);
-    void initImg(int w, int h);
     template<typename T> std::vector<std::vector<T>> group(std::vector<T> items, uint nGroups);
     void processClustersAsync(const std::vector<std::vector<Coordinate>>& clusters);
 
 private:
     std::mt19937 rng;
-    GlImage* img;
+    Canvas* img;
     int nRanPoints;
     int kClusters;
     std::vector<Coordinate> points;
+    std::unique_ptr<Clusterer> clusterer;
+    ResultCache cache;
+    ulong clusterSeed;
+    CancelToken cancelToken;
+    Progress progress;
 };
 
 
@@ -5,11 +5,11 @@ Coordinate::Coordinate(int x, int y){
     this->y = y;
 }
 
-int Coordinate::getX(){
+int Coordinate::getX() const{
     return this->x;
 }
 
-int Coordinate::getY(){
+int Coordinate::getY() const{
     return this->y;
 }
 
@@ -7,8 +7,8 @@
 class Coordinate {
 public:
     Coordinate(int x=0, int y=0);
-    int getX();
-    int getY();
+    int getX() const;
+    int getY() const;
     void setX(int val);
     void setY(int val);
     bool equal(Coordinate c);
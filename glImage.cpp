@@ -17,8 +17,21 @@ GlImage::GlImage(int w, int h){
         }
     }
 
+    this->frontVector = this->imgVector;
     this->imgWidth = w;
     this->imgHeight = h;
+    this->newFrame = true;
+
+    int nBands = (h + DIRTY_BAND_HEIGHT - 1) / DIRTY_BAND_HEIGHT;
+    this->backDirty.resize(nBands);
+    this->frontDirty.resize(nBands);
+    resetDirty(this->backDirty);
+
+    // The first upload has to send the whole image
+    for(auto& band: this->frontDirty){
+        band.minX = 0;
+        band.maxX = w - 1;
+    }
 }
 
 GlImage::~GlImage() = default;
@@ -38,10 +51,47 @@ void GlImage::setPixel(int x, int y, int r, int g, int b){
     this->imgVector[loc].r = r;
     this->imgVector[loc].g = g;
     this->imgVector[loc].b = b;
+    markDirty(x, x, y);
+}
+
+/**
+ * Sets len pixels of row y starting at x to the given color channels
+ */
+void GlImage::setSpan(int x, int y, int len, int r, int g, int b){
+    if(y >= this->imgHeight || y < 0){
+        return;
+    }
+
+    int x0 = std::max(x, 0);
+    int x1 = std::min(x + len, this->imgWidth) - 1;
+    if(x0 > x1){
+        return;
+    }
+
+    std::lock_guard<std::mutex> lk(mutex);
+    for(int loc = y * this->imgWidth + x0; loc <= y * this->imgWidth + x1; loc++){
+        this->imgVector[loc].r = r;
+        this->imgVector[loc].g = g;
+        this->imgVector[loc].b = b;
+    }
+    markDirty(x0, x1, y);
 }
 
+/**
+ * Sets the whole image black
+ */
+void GlImage::clear(){
+    for(int y = 0; y < this->imgHeight; y++){
+        setSpan(0, y, this->imgWidth, 0, 0, 0);
+    }
+}
+
+/**
+ * Returns the front buffer, the last published copy of the image.
+ * Callers should hold lockFront() while reading it.
+ */
 GlPixel* GlImage::getImg(){
-    return &this->imgVector[0];
+    return &this->frontVector[0];
 }
 
 int GlImage::getHeight() {
@@ -61,3 +111,96 @@ GlPixel GlImage::getPixel(int y, int x) {
     return this->imgVector[y * this->imgWidth + x];
 }
 
+/**
+ * Copies the regions drawn since the last publish over to the front buffer used for display.
+ * Publishes are rate limited to PUBLISH_INTERVAL_MS unless forced, so a worker can
+ * call this after every layer without copying the image each time.
+ * @param force Publish even if the last publish was recent
+ */
+void GlImage::publish(bool force) {
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lk(mutex);
+    if(!force && now - lastPublish < std::chrono::milliseconds(PUBLISH_INTERVAL_MS)){
+        return;
+    }
+
+    std::lock_guard<std::mutex> frontLk(frontMutex);
+    bool changed = false;
+    for(int band = 0; band < this->backDirty.size(); band++){
+        DirtySpan& back = this->backDirty[band];
+        if(back.minX > back.maxX){
+            continue;
+        }
+
+        int yEnd = std::min((band + 1) * DIRTY_BAND_HEIGHT, this->imgHeight);
+        for(int y = band * DIRTY_BAND_HEIGHT; y < yEnd; y++){
+            auto rowStart = this->imgVector.begin() + y * this->imgWidth;
+            std::copy(rowStart + back.minX, rowStart + back.maxX + 1, this->frontVector.begin() + y * this->imgWidth + back.minX);
+        }
+
+        DirtySpan& front = this->frontDirty[band];
+        front.minX = std::min(front.minX, back.minX);
+        front.maxX = std::max(front.maxX, back.maxX);
+        changed = true;
+    }
+    resetDirty(this->backDirty);
+
+    this->lastPublish = now;
+    if(changed){
+        this->newFrame = true;
+    }
+}
+
+/**
+ * Returns whether a new frame was published since the last call
+ */
+bool GlImage::frameReady() {
+    return this->newFrame.exchange(false);
+}
+
+/**
+ * Locks the front buffer so it is not swapped while being displayed
+ */
+std::unique_lock<std::mutex> GlImage::lockFront() {
+    return std::unique_lock<std::mutex>(frontMutex);
+}
+
+/**
+ * Returns the regions of the front buffer changed since the last call and marks them clean.
+ * Callers should hold lockFront().
+ * @return List of changed rectangles, at most one per band
+ */
+std::vector<DirtyRect> GlImage::takeDirty() {
+    std::vector<DirtyRect> rects;
+
+    for(int band = 0; band < this->frontDirty.size(); band++){
+        DirtySpan& span = this->frontDirty[band];
+        if(span.minX > span.maxX){
+            continue;
+        }
+
+        int y = band * DIRTY_BAND_HEIGHT;
+        rects.push_back({span.minX, y, span.maxX - span.minX + 1, std::min(DIRTY_BAND_HEIGHT, this->imgHeight - y)});
+    }
+    resetDirty(this->frontDirty);
+
+    return rects;
+}
+
+/**
+ * Grows the dirty span of the band holding row y to cover columns x0 to x1.
+ * Callers should hold the back buffer mutex.
+ */
+void GlImage::markDirty(int x0, int x1, int y) {
+    DirtySpan& band = this->backDirty[y / DIRTY_BAND_HEIGHT];
+    band.minX = std::min(band.minX, x0);
+    band.maxX = std::max(band.maxX, x1);
+}
+
+void GlImage::resetDirty(std::vector<DirtySpan>& bands) {
+    for(auto& band: bands){
+        band.minX = std::numeric_limits<int>::max();
+        band.maxX = -1;
+    }
+}
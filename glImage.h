@@ -5,22 +5,58 @@
 #include <vector>
 #include <iostream>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <algorithm>
 #include "glPixel.h"
+#include "canvas.h"
 
-class GlImage {
+#define PUBLISH_INTERVAL_MS 16
+#define DIRTY_BAND_HEIGHT 32
+
+struct DirtyRect {
+    int x;
+    int y;
+    int w;
+    int h;
+};
+
+class GlImage : public Canvas {
 public:
     explicit GlImage(int w=0, int h=0);
-    ~GlImage();
-    void setPixel(int X, int y, int r, int g, int b);
+    ~GlImage() override;
+    void setPixel(int X, int y, int r, int g, int b) override;
+    void setSpan(int x, int y, int len, int r, int g, int b) override;
+    void clear() override;
     GlPixel* getImg();
-    int getHeight();
-    int getWidth();
+    int getHeight() override;
+    int getWidth() override;
     GlPixel getPixel(int y, int x);
+    void publish(bool force = false) override;
+    bool frameReady();
+    std::unique_lock<std::mutex> lockFront();
+    std::vector<DirtyRect> takeDirty();
+private:
+    // Dirty columns [minX, maxX] of one band of DIRTY_BAND_HEIGHT rows, empty when minX > maxX
+    struct DirtySpan {
+        int minX;
+        int maxX;
+    };
+
+    void markDirty(int x0, int x1, int y);
+    static void resetDirty(std::vector<DirtySpan>& bands);
 private:
     std::mutex mutex;
+    std::mutex frontMutex;
     int imgHeight;
     int imgWidth;
     std::vector<GlPixel> imgVector;
+    std::vector<GlPixel> frontVector;
+    std::vector<DirtySpan> backDirty;
+    std::vector<DirtySpan> frontDirty;
+    std::atomic<bool> newFrame;
+    std::chrono::steady_clock::time_point lastPublish;
 };
 
 
@@ -1,3 +1,7 @@
 #include "glPixel.h"
 
-GlPixel::GlPixel()= default;
\ No newline at end of file
+#ifdef GL_PIXEL_RGBA
+GlPixel::GlPixel() : a(255) {}
+#else
+GlPixel::GlPixel()= default;
+#endif
\ No newline at end of file
@@ -3,6 +3,13 @@
 
 #include <GL/glut.h>
 
+// Build with GL_PIXEL_RGBA to store 4-byte pixels, which keeps rows aligned for upload
+#ifdef GL_PIXEL_RGBA
+#define GL_PIXEL_FORMAT GL_RGBA
+#else
+#define GL_PIXEL_FORMAT GL_RGB
+#endif
+
 class GlPixel {
 public:
     GlPixel();
@@ -10,6 +17,9 @@ public:
     GLubyte r;
     GLubyte g;
     GLubyte b;
+#ifdef GL_PIXEL_RGBA
+    GLubyte a;
+#endif
 };
 
 
@@ -0,0 +1,119 @@
+#include "gridPartitioner.h"
+#include <algorithm>
+#include <future>
+#include <limits>
+#include <thread>
+
+/**
+ * Partitions the data into k balanced groups of neighbouring points
+ * @param data Data Points
+ * @param k K groups
+ * @param rng Unused, the partition is deterministic
+ * @return Group index of every data point, in the order of data
+ */
+std::vector<int> GridPartitioner::assign(const std::vector<Coordinate>& data, int k, std::mt19937& rng) {
+    size_t n = data.size();
+    std::vector<int> assignments(n, 0);
+    if(n == 0 || k <= 1){
+        return assignments;
+    }
+
+    int minX = std::numeric_limits<int>::max(), minY = std::numeric_limits<int>::max();
+    int maxX = std::numeric_limits<int>::min(), maxY = std::numeric_limits<int>::min();
+    for(const Coordinate& c: data){
+        minX = std::min(minX, c.getX());
+        maxX = std::max(maxX, c.getX());
+        minY = std::min(minY, c.getY());
+        maxY = std::max(maxY, c.getY());
+    }
+
+    // Enough cells for a handful of points each
+    int bits = 0;
+    while(bits < GRID_MAX_BITS && ((size_t)1 << (2 * bits)) * GRID_POINTS_PER_CELL < n){
+        bits++;
+    }
+    uint32_t gridSize = 1u << bits;
+    size_t nCells = (size_t)gridSize * gridSize;
+
+    double scaleX = (double)gridSize / ((long)maxX - minX + 1);
+    double scaleY = (double)gridSize / ((long)maxY - minY + 1);
+
+    size_t maxThreads = std::max<size_t>(1, GRID_MAX_HISTOGRAM_BYTES / (nCells * sizeof(size_t)));
+    size_t nThreads = std::min<size_t>({std::max(1u, std::thread::hardware_concurrency()), n / GRID_POINTS_PER_THREAD + 1, maxThreads});
+    size_t chunk = (n + nThreads - 1) / nThreads;
+
+    // Cell of every point and a histogram of cells per chunk
+    std::vector<uint32_t> cells(n);
+    std::vector<std::vector<size_t>> counts(nThreads, std::vector<size_t>(nCells, 0));
+
+    forEachChunk(nThreads, [&](size_t t){
+        size_t end = std::min(n, (t + 1) * chunk);
+        for(size_t p = t * chunk; p < end; p++){
+            auto cx = (uint32_t)((data[p].getX() - (long)minX) * scaleX);
+            auto cy = (uint32_t)((data[p].getY() - (long)minY) * scaleY);
+            cells[p] = morton(std::min(cx, gridSize - 1), std::min(cy, gridSize - 1));
+            counts[t][cells[p]]++;
+        }
+    });
+
+    // Turn the histograms into the rank of the first point of each chunk in each cell
+    size_t rank = 0;
+    for(size_t c = 0; c < nCells; c++){
+        for(size_t t = 0; t < nThreads; t++){
+            size_t count = counts[t][c];
+            counts[t][c] = rank;
+            rank += count;
+        }
+    }
+
+    forEachChunk(nThreads, [&](size_t t){
+        size_t end = std::min(n, (t + 1) * chunk);
+        for(size_t p = t * chunk; p < end; p++){
+            size_t pointRank = counts[t][cells[p]]++;
+            assignments[p] = (int)(pointRank * k / n);
+        }
+    });
+
+    return assignments;
+}
+
+/**
+ * Runs fn for every chunk index below nThreads, on the calling thread when there is only one
+ */
+void GridPartitioner::forEachChunk(size_t nThreads, const std::function<void(size_t)>& fn) {
+    if(nThreads == 1){
+        fn(0);
+        return;
+    }
+
+    std::vector<std::future<void>> futures;
+    for(size_t t = 0; t < nThreads; t++){
+        futures.push_back(std::async(std::launch::async, fn, t));
+    }
+    for(auto& future: futures){
+        future.wait();
+    }
+}
+
+std::string GridPartitioner::getName() {
+    return "grid";
+}
+
+/**
+ * Interleaves the bits of x and y into a Morton (Z-order) code
+ */
+uint32_t GridPartitioner::morton(uint32_t x, uint32_t y) {
+    return spreadBits(x) | (spreadBits(y) << 1);
+}
+
+/**
+ * Spreads the low 16 bits of v out to the even bits
+ */
+uint32_t GridPartitioner::spreadBits(uint32_t v) {
+    v &= 0x0000FFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
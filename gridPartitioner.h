@@ -0,0 +1,32 @@
+#ifndef GRID_PARTITIONER_H
+#define GRID_PARTITIONER_H
+
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include "clusterer.h"
+
+#define GRID_MAX_BITS 9
+#define GRID_POINTS_PER_CELL 8
+#define GRID_POINTS_PER_THREAD 65536
+// Every thread keeps a histogram of all cells, the thread count is capped to keep them within this
+#define GRID_MAX_HISTOGRAM_BYTES (16 << 20)
+
+/**
+ * Single pass partitioner. Points are bucketed into a grid whose cells are ordered along a
+ * Morton curve, then the curve is cut into k runs of equal size. Groups are balanced to within
+ * one point and spatially compact, but are not k-means clusters. Runs in O(n + threads * cells) time
+ * and memory, up to 2^18 cells and one histogram of 8 bytes per cell for each thread.
+ */
+class GridPartitioner : public Clusterer {
+public:
+    std::vector<int> assign(const std::vector<Coordinate>& data, int k, std::mt19937& rng) override;
+    std::string getName() override;
+private:
+    static uint32_t morton(uint32_t x, uint32_t y);
+    static uint32_t spreadBits(uint32_t v);
+    static void forEachChunk(size_t nThreads, const std::function<void(size_t)>& fn);
+};
+
+
+#endif //GRID_PARTITIONER_H
@@ -8,19 +8,55 @@
  * @return List of clustered data
  */
 std::vector<std::vector<Coordinate>> KMeans::group(std::vector<Coordinate> data, int k, int nIterations, std::mt19937 rng){
+    std::vector<int> assignments = assign(data, k, nIterations, rng);
+
+    std::vector<std::vector<Coordinate>> clusteredData(k);
+    for(int p = 0; p < data.size(); p++){
+        clusteredData[assignments[p]].push_back(data[p]);
+    }
+
+    return clusteredData;
+}
+
+/**
+ * Applies the k-means clustering algorithm to a list of points
+ * @param data Data Points
+ * @param k K  clusters
+ * @param nIterations Number of iterations to do
+ * @param startCentroids Optional centroids to warm start from, missing ones are picked at random.
+ *                       Replaced with the final centroids.
+ * @param progress Optional counters advanced every iteration
+ * @param cancel Optional token checked every iteration, a cancelled run assigns points to the centroids reached so far
+ * @return Cluster index of every data point, in the order of data
+ */
+std::vector<int> KMeans::assign(const std::vector<Coordinate>& data, int k, int nIterations, std::mt19937 rng,
+                                std::vector<Coordinate>* startCentroids, Progress* progress, const CancelToken* cancel){
 
     std::vector<Coordinate> centroids;
 
-    std::uniform_int_distribution<std::mt19937::result_type> dist(0, data.size());
+    std::uniform_int_distribution<std::mt19937::result_type> dist(0, data.size() - 1);
 
     centroids.reserve(k);
-    for(int i = 0; i < k; i++){
+    if(startCentroids != nullptr){
+        for(int i = 0; i < k && i < startCentroids->size(); i++){
+            centroids.push_back((*startCentroids)[i]);
+        }
+    }
+    while(centroids.size() < k){
         centroids.push_back(data[dist(rng)]);
     }
 
-    std::vector<int> assignments(data.size());
+    std::vector<int> assignments(data.size(), -1);
+
+    if(progress != nullptr){
+        progress->begin("Iterations Complete.", nIterations);
+    }
 
     for(int i = 0; i < nIterations; i++){
+        if(cancel != nullptr && cancel->isCancelled()){
+            break;
+        }
+        bool changed = false;
 
         for(int p = 0; p < data.size(); p++){
             long minDis = std::numeric_limits<long>::max();
@@ -34,16 +70,21 @@ std::vector<std::vector<Coordinate>> KMeans::group(std::vector<Coordinate> data,
                     bestCluster = j;
                 }
             }
+            changed |= assignments[p] != bestCluster;
             assignments[p] = bestCluster;
         }
 
+        // Unchanged assignments give unchanged centroids, the remaining iterations would be no-ops
+        if(!changed){
+            break;
+        }
 
-        std::vector<Coordinate> newCentroids(k);
+        std::vector<long> sumX(k, 0), sumY(k, 0);
         std::vector<int> occurrences(k, 0);
         for(int p = 0; p < data.size(); p++){
             int cluster = assignments[p];
-            newCentroids[cluster].setX(newCentroids[cluster].getX() + data[p].getX());
-            newCentroids[cluster].setY(newCentroids[cluster].getY() + data[p].getY());
+            sumX[cluster] += data[p].getX();
+            sumY[cluster] += data[p].getY();
             occurrences[cluster] += 1;
         }
 
@@ -51,34 +92,40 @@ std::vector<std::vector<Coordinate>> KMeans::group(std::vector<Coordinate> data,
         for(int c = 0; c < k; c++){
             int occurrence = std::max(1, occurrences[c]);
 
-            centroids[c].setX(newCentroids[c].getX() / occurrence);
-            centroids[c].setY(newCentroids[c].getY() / occurrence);
+            centroids[c].setX((int)(sumX[c] / occurrence));
+            centroids[c].setY((int)(sumY[c] / occurrence));
         }
 
-        std::cout << "\r"  << i+1 << "/" << nIterations << " Iterations Complete." << std::flush;
+        if(progress != nullptr){
+            progress->advance();
+        }
+    }
+    if(progress != nullptr){
+        progress->finish();
     }
-    std::cout << std::endl;
-
-    std::vector<std::vector<Coordinate>> clusteredData(k);
 
-    for(Coordinate cord: data){
+    for(int p = 0; p < data.size(); p++){
         long minDis = std::numeric_limits<long>::max();
         int bestCluster = -1;
 
         for(int j = 0; j < k; j++){
-            long dis = getSqDis(cord, centroids[j]);
+            long dis = getSqDis(data[p], centroids[j]);
 
             if(dis < minDis){
                 minDis = dis;
                 bestCluster = j;
             }
         }
-        clusteredData[bestCluster].push_back(cord);
+        assignments[p] = bestCluster;
     }
 
-    return clusteredData;
+    if(startCentroids != nullptr){
+        *startCentroids = centroids;
+    }
+
+    return assignments;
 }
 
 long KMeans::getSqDis(Coordinate begin, Coordinate end){
-    return (begin.getX() - end.getX())*(begin.getX() - end.getX()) + (begin.getY() - end.getY())*(begin.getY() - end.getY());
+    return ((long)begin.getX() - end.getX())*((long)begin.getX() - end.getX()) + ((long)begin.getY() - end.getY())*((long)begin.getY() - end.getY());
 }
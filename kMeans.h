@@ -3,6 +3,7 @@
 
 #include <vector>
 #include "coordinate.h"
+#include "progress.h"
 #include <iostream>
 #include <random>
 #include <limits>
@@ -10,6 +11,8 @@
 class KMeans {
 public:
     static std::vector<std::vector<Coordinate>> group(std::vector<Coordinate> data, int k, int nIterations, std::mt19937 rng);
+    static std::vector<int> assign(const std::vector<Coordinate>& data, int k, int nIterations, std::mt19937 rng,
+                                   std::vector<Coordinate>* startCentroids = nullptr, Progress* progress = nullptr, const CancelToken* cancel = nullptr);
 private:
     static long getSqDis(Coordinate begin, Coordinate end);
 };
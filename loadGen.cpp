@@ -0,0 +1,149 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <unordered_set>
+#include <unistd.h>
+#include "peelProtocol.h"
+
+/**
+ * Load generator for the peeling daemon. Every client keeps one request in flight
+ * on its own connection and the latencies of all clients are reported together.
+ */
+
+struct LoadOptions {
+    std::string socketPath;
+    int nClients = 8;
+    int nRequests = 1000;
+    int nPoints = 200;
+    uint32_t op = PEEL_OP_LAYERS;
+    uint32_t k = 4;
+    uint32_t iterations = 20;
+};
+
+/**
+ * Sends opts.nRequests requests of random unique points and records the latency of each in microseconds
+ * @return Whether every request got a successful response
+ */
+bool runClient(const LoadOptions& opts, int clientId, std::vector<double>& latencies) {
+    int fd = connectSocket(opts.socketPath.c_str());
+    if(fd < 0){
+        std::cerr << "Error: could not connect to " << opts.socketPath << std::endl;
+        return false;
+    }
+
+    std::mt19937 rng(clientId);
+    std::uniform_int_distribution<int> dist(0, 999);
+    std::vector<int32_t> points;
+    std::unordered_set<int> used;
+    std::vector<uint32_t> body;
+
+    for(int r = 0; r < opts.nRequests; r++){
+        points.clear();
+        used.clear();
+        while(points.size() < (size_t)opts.nPoints * 2){
+            int x = dist(rng), y = dist(rng);
+            if(used.insert(y * 1000 + x).second){
+                points.push_back(x);
+                points.push_back(y);
+            }
+        }
+
+        RequestHeader request{PEEL_MAGIC, (uint32_t)r, opts.op, opts.k, opts.iterations, (uint32_t)opts.nPoints, (uint64_t)rng()};
+        ResponseHeader response{};
+
+        auto start = std::chrono::steady_clock::now();
+        bool ok = writeFully(fd, &request, sizeof(request))
+                && writeFully(fd, points.data(), points.size() * sizeof(int32_t))
+                && readFully(fd, &response, sizeof(response));
+
+        if(ok && response.status == PEEL_STATUS_OK){
+            size_t bodySize = opts.op == PEEL_OP_LAYERS ? response.nGroups + (size_t)response.nValues * 2 : response.nValues;
+            body.resize(bodySize);
+            ok = readFully(fd, body.data(), bodySize * sizeof(uint32_t));
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        if(!ok || response.magic != PEEL_MAGIC || response.id != (uint32_t)r || response.status != PEEL_STATUS_OK){
+            std::cerr << "Error: request " << r << " of client " << clientId << " failed." << std::endl;
+            close(fd);
+            return false;
+        }
+
+        latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+
+    close(fd);
+    return true;
+}
+
+double quantile(const std::vector<double>& sorted, double q) {
+    if(sorted.empty()){
+        return 0;
+    }
+    return sorted[std::min(sorted.size() - 1, (size_t)(q * (double)sorted.size()))];
+}
+
+int main(int argc, char** argv) {
+    LoadOptions opts;
+
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+
+        if(arg == "--clients" && i + 1 < argc){
+            opts.nClients = std::stoi(argv[++i]);
+        }else if(arg == "--requests" && i + 1 < argc){
+            opts.nRequests = std::stoi(argv[++i]);
+        }else if(arg == "--points" && i + 1 < argc){
+            opts.nPoints = std::stoi(argv[++i]);
+        }else if(arg == "--cluster"){
+            opts.op = PEEL_OP_CLUSTER;
+        }else if(arg == "--partition"){
+            opts.op = PEEL_OP_PARTITION;
+        }else if(arg == "--k" && i + 1 < argc){
+            opts.k = (uint32_t)std::stoi(argv[++i]);
+        }else if(arg == "--iterations" && i + 1 < argc){
+            opts.iterations = (uint32_t)std::stoi(argv[++i]);
+        }else if(opts.socketPath.empty() && arg.compare(0, 2, "--") != 0){
+            opts.socketPath = arg;
+        }else{
+            opts.socketPath.clear();
+            break;
+        }
+    }
+
+    if(opts.socketPath.empty() || opts.nClients < 1 || opts.nRequests < 1 || opts.nPoints < 3 || opts.nPoints > 1000000){
+        std::cout << "Usage: peelLoadGen socket [--clients n] [--requests n] [--points n] [--cluster|--partition] [--k n] [--iterations n]" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::vector<double>> latencies(opts.nClients);
+    std::vector<std::thread> clients;
+    std::vector<char> succeeded(opts.nClients, 0);
+
+    auto start = std::chrono::steady_clock::now();
+    for(int c = 0; c < opts.nClients; c++){
+        clients.emplace_back([&, c](){
+            succeeded[c] = runClient(opts, c, latencies[c]);
+        });
+    }
+    for(auto& client: clients){
+        client.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+    for(auto& clientLatencies: latencies){
+        all.insert(all.end(), clientLatencies.begin(), clientLatencies.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    std::cout << all.size() << " requests of " << opts.nPoints << " points from " << opts.nClients << " clients in " << seconds << " s" << std::endl;
+    std::cout << "Throughput: " << (double)all.size() / seconds << " requests/s" << std::endl;
+    std::cout << "Latency p50: " << quantile(all, 0.50) << " us, p99: " << quantile(all, 0.99) << " us, max: " << (all.empty() ? 0 : all.back()) << " us" << std::endl;
+
+    return std::all_of(succeeded.begin(), succeeded.end(), [](char ok){ return ok; }) ? 0 : 1;
+}
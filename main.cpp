@@ -1,23 +1,178 @@
+#define GL_GLEXT_PROTOTYPES
 #include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <functional>
 #include "convexHull.h"
+#include "glImage.h"
+#include "tiledImage.h"
+#include "peelDaemon.h"
+#include "gridPartitioner.h"
+#include "monteCarlo.h"
+
+#define REFRESH_INTERVAL_MS 16
 
 GlImage* img = nullptr;
 ConvexHull* cv = nullptr;
+ProgressReporter* reporter = nullptr;
+std::thread worker;
+double approxEpsilon = 0.01;
+int kMeansIterations = MAX_ITERATIONS;
+GLuint texture = 0;
+GLuint pbo = 0;
 
 void resize(int width, int height){
 }
 
 /**
- * initially displays the loaded image from memory
+ * Creates the texture the image is streamed into, and a pixel buffer object to stage uploads
+ * when the context is GL 2.1 or later
+ */
+void initTexture(){
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_PIXEL_FORMAT, img->getWidth(), img->getHeight(), 0, GL_PIXEL_FORMAT, GL_UNSIGNED_BYTE, nullptr);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, sizeof(GlPixel) % 4 == 0 ? 4 : 1);
+
+    // Pixel buffer objects are core from GL 2.1, the core entry points used for them may be missing on
+    // older contexts even when they expose GL_ARB_pixel_buffer_object
+    int major = 0, minor = 0;
+    const char* version = (const char*)glGetString(GL_VERSION);
+    if(version != nullptr && std::sscanf(version, "%d.%d", &major, &minor) == 2 && (major > 2 || (major == 2 && minor >= 1))){
+        glGenBuffers(1, &pbo);
+    }
+}
+
+/**
+ * Uploads dirty regions straight from client memory, used when no pixel buffer object can be written
+ */
+void uploadDirect(const std::vector<DirtyRect>& rects, const GlPixel* pixels, int w){
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, w);
+    for(const DirtyRect& rect: rects){
+        glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.w, rect.h, GL_PIXEL_FORMAT, GL_UNSIGNED_BYTE, pixels + rect.y * w + rect.x);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+/**
+ * Uploads the regions of the image changed since the last upload into the texture
+ */
+void uploadDirty(){
+    auto lk = img->lockFront();
+    std::vector<DirtyRect> rects = img->takeDirty();
+    if(rects.empty()){
+        return;
+    }
+
+    GlPixel* pixels = img->getImg();
+    int w = img->getWidth();
+
+    if(pbo == 0){
+        uploadDirect(rects, pixels, w);
+        return;
+    }
+
+    size_t total = 0;
+    for(DirtyRect& rect: rects){
+        total += (size_t)rect.w * rect.h * sizeof(GlPixel);
+    }
+
+    // Orphan the previous storage so the driver does not wait on the last upload
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)total, nullptr, GL_STREAM_DRAW);
+    auto* staging = (GlPixel*)glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+    if(staging == nullptr){
+        // The dirty regions are already taken, upload them directly rather than lose them
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        uploadDirect(rects, pixels, w);
+        return;
+    }
+
+    GlPixel* dst = staging;
+    for(DirtyRect& rect: rects){
+        for(int y = rect.y; y < rect.y + rect.h; y++){
+            std::memcpy(dst, pixels + y * w + rect.x, rect.w * sizeof(GlPixel));
+            dst += rect.w;
+        }
+    }
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    lk.unlock();
+
+    size_t offset = 0;
+    for(DirtyRect& rect: rects){
+        glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.w, rect.h, GL_PIXEL_FORMAT, GL_UNSIGNED_BYTE, (GLvoid*)offset);
+        offset += (size_t)rect.w * rect.h * sizeof(GlPixel);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+/**
+ * Displays the image from memory, streaming only the changed regions to the texture
  */
 void initDisplay(){
     if(img == nullptr)
         return;
 
-    glDrawPixels(img->getWidth(), img->getHeight(), GL_RGB, GL_UNSIGNED_BYTE, (GLubyte*)img->getImg());
+    glBindTexture(GL_TEXTURE_2D, texture);
+    uploadDirty();
+
+    glEnable(GL_TEXTURE_2D);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0, 0); glVertex2f(-1, -1);
+    glTexCoord2f(1, 0); glVertex2f(1, -1);
+    glTexCoord2f(1, 1); glVertex2f(1, 1);
+    glTexCoord2f(0, 1); glVertex2f(-1, 1);
+    glEnd();
+    glDisable(GL_TEXTURE_2D);
     glFlush();
 }
 
+/**
+ * Polls for frames published by the worker and redraws when one is ready
+ */
+void refresh(int value){
+    if(img != nullptr && img->frameReady()){
+        glutPostRedisplay();
+    }
+    glutTimerFunc(REFRESH_INTERVAL_MS, refresh, value);
+}
+
+/**
+ * Cancels the running job, if any, and waits for it to release its threads
+ */
+void stopJob(){
+    if(worker.joinable()){
+        cv->cancel();
+        worker.join();
+    }
+    cv->clearCancel();
+}
+
+/**
+ * Runs a job off the GLUT thread. Results are picked up by refresh as they are published.
+ * @param job Work to run on the background thread
+ */
+void startJob(const std::function<void()>& job){
+    stopJob();
+    worker = std::thread([job](){
+        job();
+        img->publish(true);
+    });
+}
+
+/**
+ * Creates the clusterer used to group points before peeling them
+ * @param grid Whether to use the grid partitioner instead of k-means
+ */
+std::unique_ptr<Clusterer> makeClusterer(bool grid){
+    if(grid){
+        return std::unique_ptr<Clusterer>(new GridPartitioner());
+    }
+    return std::unique_ptr<Clusterer>(new KMeansClusterer(kMeansIterations));
+}
+
 /**
  * Menu functions represented in keyboard input
  *
@@ -32,27 +187,43 @@ void keyboard(unsigned char key, int x, int y){
     switch (key){
         case 'q':
         case 'Q':
+            stopJob();
+            delete reporter;
             delete img;
             delete cv;
             exit(0);
         case 'r':
         case 'R':
+            stopJob();
             cv->generatePoints();
             break;
         case 'c':
         case 'C':
-            cv->convHull(cv->getAllPoints());
-            glutPostRedisplay();
+            startJob([](){ cv->convHull(cv->getAllPoints()); });
             break;
         case 'p':
         case 'P':
-            cv->convPeel(cv->getAllPoints());
-            glutPostRedisplay();
+            startJob([](){ cv->convPeel(cv->getAllPoints()); });
             break;
         case 'k':
         case 'K':
-            cv->clusterPeels();
-            glutPostRedisplay();
+            startJob([](){ cv->clusterPeels(); });
+            break;
+        case 'a':
+        case 'A':
+            startJob([](){ cv->approxPeel(approxEpsilon); });
+            break;
+        case '+':
+        case '-':
+            stopJob();
+            cv->setClusters(std::max(1, std::min((int)cv->getAllPoints().size(), cv->getClusters() + (key == '+' ? 1 : -1))));
+            std::cout << "k = " << cv->getClusters() << std::endl;
+            break;
+        case 'g':
+        case 'G':
+            stopJob();
+            cv->setClusterer(makeClusterer(dynamic_cast<GridPartitioner*>(cv->getClusterer()) == nullptr));
+            std::cout << "Clustering with " << cv->getClusterer()->getName() << std::endl;
             break;
         default:break;
     }
@@ -64,8 +235,60 @@ void printMenu(){
     std::cout << "C - Apply Convex Hull to Image" << std::endl;
     std::cout << "P - Apply Convex Peel to Image" << std::endl;
     std::cout << "K - Apply K-Means Clustering to Convex Peel" << std::endl;
+    std::cout << "A - Apply Approximate Convex Peel to Image" << std::endl;
+    std::cout << "+/- - Change K" << std::endl;
+    std::cout << "G - Toggle between K-Means and Grid Partitioning for K" << std::endl;
+}
+
+
+void printUsage(){
+    std::cout << "Usage: kMeansPeel [points k] [--canvas WxH] [--out file.ppm|file.png] [--tile-file file] [--cluster] [--partition grid|kmeans] [--iterations n] [--approx epsilon]" << std::endl;
+    std::cout << "       kMeansPeel [points k] --trials n [--threads n] [--seed n] [--iterations n] [--canvas WxH] [--cluster] [--partition grid|kmeans]" << std::endl;
+    std::cout << "       kMeansPeel --daemon socket [--workers n]" << std::endl;
+    std::cout << "  --out renders without a window onto a tiled canvas and writes it to the file" << std::endl;
+    std::cout << "  --partition picks how --cluster and K group points, grid is faster than k-means but not exact" << std::endl;
+    std::cout << "  --approx finds every layer from the column and row extremes of a grid of 1/epsilon cells per side, used by --out and A" << std::endl;
+    std::cout << "  --trials runs n seeded generate, cluster and peel trials without drawing and reports statistics" << std::endl;
+    std::cout << "  --daemon serves peel and cluster requests on a Unix domain socket" << std::endl;
 }
 
+/**
+ * Peels the points on a tiled canvas and streams the result to a file, without opening a window
+ * @param w Canvas width
+ * @param h Canvas height
+ * @param outPath PPM or PNG file to write
+ * @param tileFile File to memory-map the tiles into, or empty to keep them in memory
+ * @param cluster Whether to cluster before peeling
+ * @param gridPartition Whether to cluster with the grid partitioner instead of k-means
+ * @param approx Whether to peel approximately with approxEpsilon
+ * @return Exit code
+ */
+int renderToFile(int w, int h, int nRanPoints, int kClusters, const std::string& outPath, const std::string& tileFile, bool cluster, bool gridPartition, bool approx){
+    TiledImage canvas(w, h, tileFile);
+
+    ulong seed = std::random_device()();
+    ConvexHull hull(&canvas, nRanPoints, kClusters, seed);
+    hull.setClusterer(makeClusterer(gridPartition));
+
+    {
+        ProgressReporter progressReporter(hull.getProgress());
+
+        if(approx){
+            hull.approxPeel(approxEpsilon);
+        }else if(cluster){
+            hull.clusterPeels();
+        }else{
+            hull.convPeel(hull.getAllPoints());
+        }
+    }
+
+    std::cout << canvas.getAllocatedTiles() << " tiles of " << TILE_SIZE << "x" << TILE_SIZE << " drawn." << std::endl;
+
+    bool png = outPath.size() >= 4 && outPath.compare(outPath.size() - 4, 4, ".png") == 0;
+    bool written = png ? canvas.writePng(outPath) : canvas.writePpm(outPath);
+
+    return written ? 0 : 1;
+}
 
 int main(int argc, char** argv) {
 
@@ -74,11 +297,78 @@ int main(int argc, char** argv) {
     int w = 1920;
     int h = 1020;
 
-    if(argc != 3){
+    std::string outPath;
+    std::string tileFile;
+    std::string daemonSocket;
+    int nWorkers = (int)std::thread::hardware_concurrency();
+    bool cluster = false;
+    bool gridPartition = false;
+    bool approx = false;
+    TrialOptions trials;
+    trials.nTrials = 0;
+    trials.nThreads = (int)std::thread::hardware_concurrency();
+    trials.seed = std::random_device()();
+    std::vector<std::string> positional;
+
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+
+        if(arg == "--canvas" && i + 1 < argc){
+            if(std::sscanf(argv[++i], "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0){
+                printUsage();
+                return 1;
+            }
+        }else if(arg == "--out" && i + 1 < argc){
+            outPath = argv[++i];
+        }else if(arg == "--tile-file" && i + 1 < argc){
+            tileFile = argv[++i];
+        }else if(arg == "--daemon" && i + 1 < argc){
+            daemonSocket = argv[++i];
+        }else if(arg == "--workers" && i + 1 < argc){
+            nWorkers = std::stoi(argv[++i]);
+        }else if(arg == "--partition" && i + 1 < argc){
+            std::string method = argv[++i];
+            if(method != "grid" && method != "kmeans"){
+                printUsage();
+                return 1;
+            }
+            gridPartition = method == "grid";
+        }else if(arg == "--approx" && i + 1 < argc){
+            approxEpsilon = std::stod(argv[++i]);
+            approx = true;
+            if(approxEpsilon <= 0 || approxEpsilon > 1){
+                printUsage();
+                return 1;
+            }
+        }else if(arg == "--trials" && i + 1 < argc){
+            trials.nTrials = std::stoi(argv[++i]);
+        }else if(arg == "--threads" && i + 1 < argc){
+            trials.nThreads = std::stoi(argv[++i]);
+        }else if(arg == "--seed" && i + 1 < argc){
+            trials.seed = std::stoul(argv[++i]);
+        }else if(arg == "--iterations" && i + 1 < argc){
+            kMeansIterations = std::stoi(argv[++i]);
+            trials.nIterations = kMeansIterations;
+        }else if(arg == "--cluster"){
+            cluster = true;
+        }else if(arg.compare(0, 2, "--") == 0){
+            printUsage();
+            return 1;
+        }else{
+            positional.push_back(arg);
+        }
+    }
+
+    if(!daemonSocket.empty()){
+        PeelDaemon daemon(daemonSocket, nWorkers);
+        return daemon.run();
+    }
+
+    if(positional.size() != 2){
         std::cout << "Number of points and k clusters not specified. Defaulting to " << nRanPoints << " and " << kClusters << ".\n";
     }else{
-        nRanPoints = std::stoi(argv[1]);
-        kClusters = std::stoi(argv[2]);
+        nRanPoints = std::stoi(positional[0]);
+        kClusters = std::stoi(positional[1]);
     }
 
     if(nRanPoints < 3){
@@ -90,6 +380,26 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    if(trials.nTrials > 0){
+        if((long)w * h / 2 < nRanPoints){
+            std::cout << "The canvas is too small for " << nRanPoints << " unique points" << std::endl;
+            return 1;
+        }
+
+        trials.nPoints = nRanPoints;
+        trials.kClusters = cluster ? kClusters : 0;
+        trials.width = w;
+        trials.height = h;
+        trials.gridPartition = gridPartition;
+
+        MonteCarlo(trials).run();
+        return 0;
+    }
+
+    if(!outPath.empty()){
+        return renderToFile(w, h, nRanPoints, kClusters, outPath, tileFile, cluster, gridPartition, approx);
+    }
+
     img = new GlImage(w, h);
 
     glutInit(&argc, argv);
@@ -100,12 +410,16 @@ int main(int argc, char** argv) {
     glShadeModel(GL_SMOOTH);
     glutDisplayFunc(initDisplay);
     glutKeyboardFunc(keyboard);
+    glutTimerFunc(REFRESH_INTERVAL_MS, refresh, 0);
     glMatrixMode(GL_PROJECTION);
+    initTexture();
 
     printMenu();
 
     ulong seed = std::random_device()();
-    cv = new ConvexHull(img, w, h, nRanPoints, kClusters, seed);
+    cv = new ConvexHull(img, nRanPoints, kClusters, seed);
+    cv->setClusterer(makeClusterer(gridPartition));
+    reporter = new ProgressReporter(cv->getProgress());
 
     glutMainLoop();
 
@@ -0,0 +1,131 @@
+#include "monteCarlo.h"
+#include "gridPartitioner.h"
+#include <chrono>
+#include <map>
+#include <iomanip>
+
+#define HISTOGRAM_WIDTH 50
+
+MonteCarlo::MonteCarlo(const TrialOptions& options) {
+    this->options = options;
+    this->options.nThreads = std::max(1, std::min(options.nThreads, options.nTrials));
+}
+
+/**
+ * Runs every trial and prints the aggregated statistics
+ */
+void MonteCarlo::run() {
+    std::vector<Samples> threadSamples(options.nThreads);
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        ProgressReporter reporter(progress);
+        progress.begin("Trials Complete.", options.nTrials);
+
+        for(int t = 0; t < options.nThreads; t++){
+            threads.emplace_back(&MonteCarlo::runTrials, this, t, options.nThreads, std::ref(threadSamples[t]));
+        }
+        for(auto& thread: threads){
+            thread.join();
+        }
+
+        progress.finish();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Samples all;
+    for(Samples& samples: threadSamples){
+        all.layerCounts.insert(all.layerCounts.end(), samples.layerCounts.begin(), samples.layerCounts.end());
+        all.hullSizes.insert(all.hullSizes.end(), samples.hullSizes.begin(), samples.hullSizes.end());
+    }
+
+    std::cout << options.nTrials << " trials of " << options.nPoints << " points";
+    if(options.kClusters > 0){
+        std::cout << " in " << options.kClusters << " clusters";
+    }
+    std::cout << " on " << options.nThreads << " threads in " << seconds << " s, " << options.nTrials / seconds << " trials/s" << std::endl;
+
+    report("Layers", all.layerCounts);
+    report("Outer hull size", all.hullSizes);
+}
+
+/**
+ * Runs trials firstTrial, firstTrial + stride, ... on the calling thread
+ */
+void MonteCarlo::runTrials(int firstTrial, int stride, Samples& samples) {
+    TrialBuffers buffers;
+    if(options.gridPartition){
+        buffers.clusterer.reset(new GridPartitioner());
+    }else{
+        buffers.clusterer.reset(new KMeansClusterer(options.nIterations));
+    }
+
+    for(int trial = firstTrial; trial < options.nTrials; trial += stride){
+        runTrial(trial, buffers, samples);
+        progress.advance();
+    }
+}
+
+void MonteCarlo::runTrial(int trial, TrialBuffers& buffers, Samples& samples) {
+    std::mt19937 rng(options.seed + trial);
+    ConvexHull::randomPoints(options.nPoints, options.width, options.height, rng, buffers.points, buffers.used);
+
+    if(options.kClusters > 0){
+        buffers.clusters = buffers.clusterer->group(buffers.points, options.kClusters, rng);
+    }else{
+        buffers.clusters.resize(1);
+        buffers.clusters[0].swap(buffers.points);
+    }
+
+    for(auto& cluster: buffers.clusters){
+        if(cluster.empty()){
+            continue;
+        }
+
+        ConvexHull::peelLayers(cluster, buffers.layers, buffers.peel);
+        samples.layerCounts.push_back((int)buffers.layers.size());
+        samples.hullSizes.push_back((int)buffers.layers[0].size());
+    }
+
+    if(options.kClusters == 0){
+        buffers.clusters[0].swap(buffers.points);
+    }
+}
+
+/**
+ * Prints the mean, quantiles and a histogram of values
+ */
+void MonteCarlo::report(const std::string& name, std::vector<int>& values) {
+    if(values.empty()){
+        return;
+    }
+    std::sort(values.begin(), values.end());
+
+    double sum = 0, sqSum = 0;
+    std::map<int, size_t> histogram;
+    for(int v: values){
+        sum += v;
+        sqSum += (double)v * v;
+        histogram[v]++;
+    }
+    double mean = sum / values.size();
+    double stdDev = std::sqrt(std::max(0.0, sqSum / values.size() - mean * mean));
+
+    auto quantile = [&](double q){
+        return values[std::min(values.size() - 1, (size_t)(q * values.size()))];
+    };
+
+    std::cout << name << ": n " << values.size() << ", mean " << mean << ", std dev " << stdDev
+              << ", min " << values.front() << ", p5 " << quantile(0.05) << ", p50 " << quantile(0.5)
+              << ", p95 " << quantile(0.95) << ", max " << values.back() << std::endl;
+
+    size_t peak = 0;
+    for(auto& bin: histogram){
+        peak = std::max(peak, bin.second);
+    }
+    for(auto& bin: histogram){
+        std::cout << std::setw(8) << bin.first << " " << std::setw(8) << bin.second << " "
+                  << std::string((bin.second * HISTOGRAM_WIDTH + peak - 1) / peak, '#') << std::endl;
+    }
+}
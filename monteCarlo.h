@@ -0,0 +1,61 @@
+#ifndef MONTE_CARLO_H
+#define MONTE_CARLO_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include "convexHull.h"
+#include "clusterer.h"
+#include "progress.h"
+
+/**
+ * Settings of a batch of Monte Carlo trials
+ */
+struct TrialOptions {
+    int nTrials = 1000;
+    int nThreads = 1;
+    int nPoints = 100;
+    int kClusters = 0;          // 0 peels the whole point set
+    int width = 1920;
+    int height = 1020;
+    int nIterations = MAX_ITERATIONS;
+    bool gridPartition = false;
+    ulong seed = 0;
+};
+
+/**
+ * Runs independent seeded generate, cluster and peel trials concurrently without drawing,
+ * and reports the distribution of the number of layers and of the outer hull sizes.
+ * Trial i is seeded with seed + i, so results do not depend on the number of threads.
+ */
+class MonteCarlo {
+public:
+    explicit MonteCarlo(const TrialOptions& options);
+    void run();
+private:
+    // Per thread state, reused from one trial to the next
+    struct TrialBuffers {
+        std::vector<Coordinate> points;
+        std::unordered_set<long> used;
+        PeelBuffers peel;
+        std::vector<std::vector<Coordinate>> layers;
+        std::vector<std::vector<Coordinate>> clusters;
+        std::unique_ptr<Clusterer> clusterer;
+    };
+
+    // Samples gathered by one thread, one per peeled cluster
+    struct Samples {
+        std::vector<int> layerCounts;
+        std::vector<int> hullSizes;
+    };
+
+    void runTrials(int firstTrial, int stride, Samples& samples);
+    void runTrial(int trial, TrialBuffers& buffers, Samples& samples);
+    static void report(const std::string& name, std::vector<int>& values);
+private:
+    TrialOptions options;
+    Progress progress;
+};
+
+
+#endif //MONTE_CARLO_H
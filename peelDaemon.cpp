@@ -0,0 +1,267 @@
+#include "peelDaemon.h"
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+PeelDaemon::Connection::Connection(int fd) {
+    this->fd = fd;
+    this->pending = 0;
+}
+
+PeelDaemon::Connection::~Connection() {
+    close(this->fd);
+}
+
+/**
+ * Creates a daemon that will listen on socketPath
+ * @param socketPath Path of the Unix domain socket, replaced if it exists
+ * @param nWorkers Number of worker threads
+ */
+PeelDaemon::PeelDaemon(const std::string& socketPath, int nWorkers) {
+    this->socketPath = socketPath;
+    this->nWorkers = std::max(1, nWorkers);
+    this->listenFd = -1;
+    this->stopping = false;
+}
+
+PeelDaemon::~PeelDaemon() {
+    {
+        std::lock_guard<std::mutex> lk(queueMutex);
+        this->stopping = true;
+    }
+    queueCv.notify_all();
+
+    for(auto& worker: workers){
+        worker.join();
+    }
+
+    if(this->listenFd >= 0){
+        close(this->listenFd);
+        unlink(this->socketPath.c_str());
+    }
+}
+
+/**
+ * Binds the socket, starts the workers and accepts connections until accepting fails
+ * @return Exit code
+ */
+int PeelDaemon::run() {
+    sockaddr_un addr{};
+    if(this->socketPath.size() >= sizeof(addr.sun_path)){
+        std::cerr << "Error: socket path " << this->socketPath << " is too long." << std::endl;
+        return 1;
+    }
+
+    this->listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, this->socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    unlink(this->socketPath.c_str());
+    if(this->listenFd < 0 || bind(this->listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(this->listenFd, SOMAXCONN) != 0){
+        std::cerr << "Error: could not listen on " << this->socketPath << std::endl;
+        return 1;
+    }
+
+    for(int i = 0; i < this->nWorkers; i++){
+        workers.emplace_back(&PeelDaemon::workerLoop, this);
+    }
+
+    std::cout << "Listening on " << this->socketPath << " with " << this->nWorkers << " workers." << std::endl;
+
+    while(true){
+        int fd = accept(this->listenFd, nullptr, nullptr);
+        if(fd < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            std::cerr << "Error: accept failed." << std::endl;
+            return 1;
+        }
+
+        std::thread(&PeelDaemon::serveConnection, this, std::make_shared<Connection>(fd)).detach();
+    }
+}
+
+/**
+ * Reads requests off a connection and queues them until the client disconnects
+ */
+void PeelDaemon::serveConnection(const std::shared_ptr<Connection>& conn) {
+    std::vector<int32_t> raw;
+
+    while(true){
+        Job job;
+        job.conn = conn;
+
+        if(!readFully(conn->fd, &job.header, sizeof(job.header))){
+            conn->closed.cancel();
+            return;
+        }
+
+        if(job.header.magic != PEEL_MAGIC || job.header.nPoints > DAEMON_MAX_POINTS){
+            ResponseHeader header{PEEL_MAGIC, job.header.id, PEEL_STATUS_BAD_REQUEST, 0, 0, 0};
+            respond(job, header, {});
+            conn->closed.cancel();
+            return;
+        }
+
+        raw.resize((size_t)job.header.nPoints * 2);
+        if(!readFully(conn->fd, raw.data(), raw.size() * sizeof(int32_t))){
+            conn->closed.cancel();
+            return;
+        }
+
+        bool inRange = true;
+        job.points.reserve(job.header.nPoints);
+        for(size_t p = 0; p < raw.size(); p += 2){
+            inRange &= raw[p] >= -DAEMON_MAX_COORDINATE && raw[p] <= DAEMON_MAX_COORDINATE
+                    && raw[p + 1] >= -DAEMON_MAX_COORDINATE && raw[p + 1] <= DAEMON_MAX_COORDINATE;
+            job.points.emplace_back(raw[p], raw[p + 1]);
+        }
+
+        bool accepted = false;
+        if(inRange && withinLimits(job.header)){
+            std::lock_guard<std::mutex> lk(queueMutex);
+            if(conn->pending < DAEMON_MAX_PENDING){
+                conn->pending++;
+                queue.push_back(std::move(job));
+                accepted = true;
+            }
+        }
+
+        if(!accepted){
+            ResponseHeader header{PEEL_MAGIC, job.header.id, PEEL_STATUS_BAD_REQUEST, 0, 0, 0};
+            respond(job, header, {});
+            continue;
+        }
+        queueCv.notify_one();
+    }
+}
+
+/**
+ * Takes batches of queued requests and serves them, reusing one set of buffers
+ */
+void PeelDaemon::workerLoop() {
+    WorkerBuffers buffers;
+
+    while(true){
+        {
+            std::unique_lock<std::mutex> lk(queueMutex);
+            queueCv.wait(lk, [this](){ return this->stopping || !queue.empty(); });
+            if(this->stopping){
+                return;
+            }
+
+            // Take a fair share of the backlog so a burst is spread over the pool
+            size_t share = (queue.size() + this->nWorkers - 1) / this->nWorkers;
+            size_t batchSize = std::min<size_t>(DAEMON_BATCH_SIZE, share);
+
+            buffers.batch.clear();
+            for(size_t i = 0; i < batchSize; i++){
+                buffers.batch.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+        }
+
+        for(Job& job: buffers.batch){
+            process(job, buffers);
+
+            std::lock_guard<std::mutex> lk(queueMutex);
+            job.conn->pending--;
+        }
+        buffers.batch.clear();
+    }
+}
+
+/**
+ * Checks the request's parameters against the daemon's caps, so no single request can tie up a worker indefinitely
+ * @return Whether the request may be queued
+ */
+bool PeelDaemon::withinLimits(const RequestHeader& request) {
+    if(request.op == PEEL_OP_LAYERS){
+        return request.nPoints <= DAEMON_MAX_PEEL_POINTS;
+    }
+    if(request.k > DAEMON_MAX_K){
+        return false;
+    }
+    if(request.op == PEEL_OP_CLUSTER){
+        long iterations = request.iterations > 0 ? request.iterations : MAX_ITERATIONS;
+        return request.iterations <= DAEMON_MAX_ITERATIONS && (long)request.nPoints * request.k * iterations <= DAEMON_MAX_KMEANS_WORK;
+    }
+    return true;
+}
+
+/**
+ * Serves one request
+ */
+void PeelDaemon::process(Job& job, WorkerBuffers& buffers) {
+    RequestHeader& request = job.header;
+    ResponseHeader header{PEEL_MAGIC, request.id, PEEL_STATUS_OK, 0, 0, 0};
+    std::vector<uint32_t>& body = buffers.response;
+    body.clear();
+
+    // Nobody is left to read the answer
+    const CancelToken& closed = job.conn->closed;
+    if(closed.isCancelled()){
+        return;
+    }
+
+    if(request.op == PEEL_OP_LAYERS){
+        // Peeling needs unique points
+        buffers.unique.assign(job.points.begin(), job.points.end());
+        std::sort(buffers.unique.begin(), buffers.unique.end(), [](const Coordinate& a, const Coordinate& b){
+            return a.getX() < b.getX() || (a.getX() == b.getX() && a.getY() < b.getY());
+        });
+        buffers.unique.erase(std::unique(buffers.unique.begin(), buffers.unique.end(), [](const Coordinate& a, const Coordinate& b){
+            return a.getX() == b.getX() && a.getY() == b.getY();
+        }), buffers.unique.end());
+
+        ConvexHull::peelLayers(buffers.unique, buffers.layers, buffers.peel, [&closed](const std::vector<Coordinate>&){
+            return !closed.isCancelled();
+        });
+        if(closed.isCancelled()){
+            return;
+        }
+
+        header.nGroups = (uint32_t)buffers.layers.size();
+        for(auto& layer: buffers.layers){
+            body.push_back((uint32_t)layer.size());
+        }
+        for(auto& layer: buffers.layers){
+            for(Coordinate& c: layer){
+                body.push_back((uint32_t)c.getX());
+                body.push_back((uint32_t)c.getY());
+            }
+        }
+        header.nValues = (uint32_t)buffers.unique.size();
+    }else if((request.op == PEEL_OP_CLUSTER || request.op == PEEL_OP_PARTITION) && request.k > 0 && request.k <= request.nPoints){
+        std::mt19937 rng(request.seed);
+        std::vector<int> assignments;
+
+        if(request.op == PEEL_OP_CLUSTER){
+            int iterations = request.iterations > 0 ? (int)request.iterations : MAX_ITERATIONS;
+            assignments = KMeans::assign(job.points, (int)request.k, iterations, rng, nullptr, nullptr, &closed);
+        }else{
+            assignments = GridPartitioner().assign(job.points, (int)request.k, rng);
+        }
+        if(closed.isCancelled()){
+            return;
+        }
+
+        header.nGroups = request.k;
+        header.nValues = (uint32_t)assignments.size();
+        body.assign(assignments.begin(), assignments.end());
+    }else{
+        header.status = PEEL_STATUS_BAD_REQUEST;
+    }
+
+    respond(job, header, body);
+}
+
+void PeelDaemon::respond(Job& job, ResponseHeader header, const std::vector<uint32_t>& body) {
+    std::lock_guard<std::mutex> lk(job.conn->writeMutex);
+    if(writeFully(job.conn->fd, &header, sizeof(header))){
+        writeFully(job.conn->fd, body.data(), body.size() * sizeof(uint32_t));
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef PEEL_DAEMON_H
+#define PEEL_DAEMON_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include "convexHull.h"
+#include "peelProtocol.h"
+#include "gridPartitioner.h"
+#include "progress.h"
+
+#define DAEMON_BATCH_SIZE 16
+#define DAEMON_MAX_POINTS (1 << 24)
+// Keeps coordinate differences below 2^31 so the 64-bit orientation products cannot overflow
+#define DAEMON_MAX_COORDINATE ((1 << 30) - 1)
+// Gift wrapping costs about n² over all layers, so peel requests are held to far fewer points than clustering ones
+#define DAEMON_MAX_PEEL_POINTS (1 << 14)
+#define DAEMON_MAX_K 4096
+#define DAEMON_MAX_ITERATIONS 10000
+// Point-to-centroid distances a single k-means request may ask for, nPoints * k * iterations
+#define DAEMON_MAX_KMEANS_WORK (1L << 34)
+// Requests a connection may have queued or in progress before further ones are refused
+#define DAEMON_MAX_PENDING 64
+
+/**
+ * Long running peeling service listening on a Unix domain socket.
+ * Connections are read on their own threads and requests are queued for a shared
+ * pool of workers, which take them in batches and keep their buffers between requests.
+ */
+class PeelDaemon {
+public:
+    PeelDaemon(const std::string& socketPath, int nWorkers);
+    ~PeelDaemon();
+    int run();
+private:
+    struct Connection {
+        explicit Connection(int fd);
+        ~Connection();
+        int fd;
+        std::mutex writeMutex;
+        size_t pending; // Guarded by the daemon's queueMutex
+        CancelToken closed; // Set once the client has gone, its queued and running jobs are dropped
+    };
+
+    struct Job {
+        std::shared_ptr<Connection> conn;
+        RequestHeader header;
+        std::vector<Coordinate> points;
+    };
+
+    struct WorkerBuffers {
+        PeelBuffers peel;
+        std::vector<std::vector<Coordinate>> layers;
+        std::vector<Coordinate> unique;
+        std::vector<uint32_t> response;
+        std::vector<Job> batch;
+    };
+
+    void serveConnection(const std::shared_ptr<Connection>& conn);
+    void workerLoop();
+    void process(Job& job, WorkerBuffers& buffers);
+    static bool withinLimits(const RequestHeader& request);
+    static void respond(Job& job, ResponseHeader header, const std::vector<uint32_t>& body);
+private:
+    std::string socketPath;
+    int nWorkers;
+    int listenFd;
+    std::mutex queueMutex;
+    std::condition_variable queueCv;
+    std::deque<Job> queue;
+    std::vector<std::thread> workers;
+    std::atomic<bool> stopping;
+};
+
+
+#endif //PEEL_DAEMON_H
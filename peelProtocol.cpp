@@ -0,0 +1,67 @@
+#include "peelProtocol.h"
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/**
+ * Reads exactly len bytes from fd
+ * @return false if the connection closed or failed first
+ */
+bool readFully(int fd, void* buf, size_t len) {
+    auto* dst = (char*)buf;
+    while(len > 0){
+        ssize_t n = read(fd, dst, len);
+        if(n < 0 && errno == EINTR){
+            continue;
+        }
+        if(n <= 0){
+            return false;
+        }
+        dst += n;
+        len -= n;
+    }
+    return true;
+}
+
+/**
+ * Writes exactly len bytes to fd
+ * @return false if the connection failed first
+ */
+bool writeFully(int fd, const void* buf, size_t len) {
+    auto* src = (const char*)buf;
+    while(len > 0){
+        ssize_t n = send(fd, src, len, MSG_NOSIGNAL);
+        if(n < 0 && errno == EINTR){
+            continue;
+        }
+        if(n <= 0){
+            return false;
+        }
+        src += n;
+        len -= n;
+    }
+    return true;
+}
+
+/**
+ * Connects to the daemon listening on the Unix socket at path
+ * @return Socket file descriptor, or -1 on failure
+ */
+int connectSocket(const char* path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0){
+        return -1;
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+    if(connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0){
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
@@ -0,0 +1,56 @@
+#ifndef PEEL_PROTOCOL_H
+#define PEEL_PROTOCOL_H
+
+#include <cstdint>
+#include <cstddef>
+
+#define PEEL_MAGIC 0x4C454550 // "PEEL"
+
+#define PEEL_OP_LAYERS 1
+#define PEEL_OP_CLUSTER 2
+#define PEEL_OP_PARTITION 3
+
+#define PEEL_STATUS_OK 0
+#define PEEL_STATUS_BAD_REQUEST 1
+
+/**
+ * Framing of the peeling daemon's Unix socket protocol, in host byte order.
+ *
+ * A request is a RequestHeader followed by nPoints pairs of int32 x, y, each within ±(2^30 - 1).
+ * A response is a ResponseHeader followed by
+ *  - PEEL_OP_LAYERS: nGroups uint32 layer sizes, then nValues int32 x, y pairs, outermost layer first
+ *  - PEEL_OP_CLUSTER, PEEL_OP_PARTITION: nValues uint32 cluster indices, one per request point in request order
+ * PEEL_OP_CLUSTER runs k-means, PEEL_OP_PARTITION the grid partitioner.
+ * Requests may be pipelined on one connection, responses carry the id of their request and can arrive out of order.
+ * Requests over the daemon's caps on peel points (DAEMON_MAX_PEEL_POINTS), k, iterations and k-means work,
+ * or sent while a connection already has DAEMON_MAX_PENDING requests outstanding, are answered with
+ * PEEL_STATUS_BAD_REQUEST. Requests still queued or running when their connection closes are dropped.
+ */
+struct RequestHeader {
+    uint32_t magic;
+    uint32_t id;
+    uint32_t op;
+    uint32_t k;
+    uint32_t iterations;
+    uint32_t nPoints;
+    uint64_t seed;
+};
+
+struct ResponseHeader {
+    uint32_t magic;
+    uint32_t id;
+    uint32_t status;
+    uint32_t nGroups;
+    uint32_t nValues;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(RequestHeader) == 32, "RequestHeader must not be padded");
+static_assert(sizeof(ResponseHeader) == 24, "ResponseHeader must not be padded");
+
+bool readFully(int fd, void* buf, size_t len);
+bool writeFully(int fd, const void* buf, size_t len);
+int connectSocket(const char* path);
+
+
+#endif //PEEL_PROTOCOL_H
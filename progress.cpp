@@ -0,0 +1,163 @@
+#include "progress.h"
+#include <iostream>
+#include <chrono>
+
+CancelToken::CancelToken() {
+    this->cancelled = false;
+}
+
+/**
+ * Requests that the job stops at its next boundary
+ */
+void CancelToken::cancel() {
+    this->cancelled.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * Clears a previous cancel request so a new job can run
+ */
+void CancelToken::reset() {
+    this->cancelled.store(false, std::memory_order_relaxed);
+}
+
+bool CancelToken::isCancelled() const {
+    return this->cancelled.load(std::memory_order_relaxed);
+}
+
+Progress::Progress() {
+    this->done = 0;
+    this->total = 0;
+    this->active = false;
+    this->generation = 0;
+}
+
+/**
+ * Starts a new stage of work
+ * @param stage Text printed after the counts
+ * @param total Amount of work in the stage
+ */
+void Progress::begin(const std::string& stage, long total) {
+    std::lock_guard<std::mutex> lk(stageMutex);
+    this->stage = stage;
+    this->done = 0;
+    this->total = total;
+    this->active = true;
+    this->generation++;
+}
+
+/**
+ * Records n more units of work done
+ */
+void Progress::advance(long n) {
+    this->done.fetch_add(n, std::memory_order_relaxed);
+}
+
+/**
+ * Ends the current stage, whether or not all of its work was done
+ */
+void Progress::finish() {
+    this->active = false;
+}
+
+/**
+ * Queues a line of output for the reporter, printed after the progress line it follows
+ */
+void Progress::note(const std::string& line) {
+    std::lock_guard<std::mutex> lk(stageMutex);
+    this->notes.push_back(line);
+}
+
+ProgressSample Progress::sample() {
+    std::lock_guard<std::mutex> lk(stageMutex);
+    return {this->stage, this->done, this->total, this->active, this->generation};
+}
+
+std::vector<std::string> Progress::takeNotes() {
+    std::lock_guard<std::mutex> lk(stageMutex);
+    std::vector<std::string> taken;
+    taken.swap(this->notes);
+    return taken;
+}
+
+ProgressReporter::ProgressReporter(Progress& progress) : progress(progress) {
+    this->stopping = false;
+    this->lastGeneration = 0;
+    this->lastDone = -1;
+    this->lineOpen = false;
+    this->finishPrinted = false;
+
+    // Stages run before the reporter existed are printed now, before the caller starts new ones
+    report();
+    this->thread = std::thread(&ProgressReporter::loop, this);
+}
+
+ProgressReporter::~ProgressReporter() {
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        this->stopping = true;
+    }
+    wake.notify_all();
+    this->thread.join();
+}
+
+void ProgressReporter::loop() {
+    std::unique_lock<std::mutex> lk(mutex);
+    while(!this->stopping){
+        wake.wait_for(lk, std::chrono::milliseconds(PROGRESS_INTERVAL_MS));
+        report();
+    }
+
+    if(this->lineOpen){
+        std::cout << std::endl;
+    }
+}
+
+/**
+ * Prints the sampled counts if they changed, ending the line once the stage finishes, then any notes
+ */
+void ProgressReporter::report() {
+    // Notes are taken first so the stage they were written after is printed up to date before them
+    std::vector<std::string> notes = progress.takeNotes();
+    reportStage();
+
+    if(!notes.empty() && this->lineOpen){
+        std::cout << std::endl;
+        this->lineOpen = false;
+    }
+    for(const std::string& line: notes){
+        std::cout << line << std::endl;
+    }
+}
+
+void ProgressReporter::reportStage() {
+    ProgressSample sample = progress.sample();
+    if(sample.generation == 0){
+        return;
+    }
+
+    if(sample.generation != this->lastGeneration){
+        if(this->lineOpen){
+            std::cout << std::endl;
+            this->lineOpen = false;
+        }
+        this->lastGeneration = sample.generation;
+        this->lastDone = -1;
+        this->finishPrinted = false;
+    }
+
+    if(this->finishPrinted){
+        return;
+    }
+
+    if(sample.done != this->lastDone || !this->lineOpen){
+        std::cout << "\r" << sample.done << "/" << sample.total << " " << sample.stage << std::flush;
+        this->lastDone = sample.done;
+        this->lineOpen = true;
+    }
+
+    if(!sample.active){
+        std::cout << std::endl;
+        this->lineOpen = false;
+        this->finishPrinted = true;
+    }
+}
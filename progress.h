@@ -0,0 +1,82 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#define PROGRESS_INTERVAL_MS 100
+
+/**
+ * Cooperative cancellation flag. Long jobs check it at layer, iteration and cluster boundaries.
+ */
+class CancelToken {
+public:
+    CancelToken();
+    void cancel();
+    void reset();
+    bool isCancelled() const;
+private:
+    std::atomic<bool> cancelled;
+};
+
+struct ProgressSample {
+    std::string stage;
+    long done;
+    long total;
+    bool active;
+    unsigned generation;
+};
+
+/**
+ * Counters a job updates as it goes. Updating them is a relaxed atomic add, the
+ * terminal is only written by a ProgressReporter sampling them. Jobs hand their
+ * other output to note so it is not printed into the middle of a progress line.
+ */
+class Progress {
+public:
+    Progress();
+    void begin(const std::string& stage, long total);
+    void advance(long n = 1);
+    void finish();
+    void note(const std::string& line);
+    ProgressSample sample();
+    std::vector<std::string> takeNotes();
+private:
+    std::mutex stageMutex;
+    std::string stage;
+    std::vector<std::string> notes;
+    std::atomic<long> done;
+    std::atomic<long> total;
+    std::atomic<bool> active;
+    std::atomic<unsigned> generation;
+};
+
+/**
+ * Prints a Progress from its own thread every PROGRESS_INTERVAL_MS until destroyed
+ */
+class ProgressReporter {
+public:
+    explicit ProgressReporter(Progress& progress);
+    ~ProgressReporter();
+private:
+    void loop();
+    void report();
+    void reportStage();
+private:
+    Progress& progress;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+    unsigned lastGeneration;
+    long lastDone;
+    bool lineOpen;
+    bool finishPrinted;
+};
+
+
+#endif //PROGRESS_H
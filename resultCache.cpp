@@ -0,0 +1,152 @@
+#include "resultCache.h"
+
+bool ResultCache::ClusterKey::operator==(const ClusterKey& other) const {
+    return points == other.points && k == other.k && seed == other.seed && method == other.method;
+}
+
+/**
+ * Looks up a clustering
+ * @param key Point set fingerprint and clustering parameters
+ * @param clusters Output, set to the cached clusters if found
+ * @return Whether the clustering was cached
+ */
+bool ResultCache::findClusters(const ClusterKey& key, std::vector<std::vector<Coordinate>>& clusters) {
+    std::lock_guard<std::mutex> lk(mutex);
+    for(auto& entry: clusterings){
+        if(entry.first == key){
+            clusters = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ResultCache::storeClusters(const ClusterKey& key, const std::vector<std::vector<Coordinate>>& clusters) {
+    size_t size = countPoints(clusters);
+    if(size > CACHE_MAX_CLUSTER_POINTS){
+        return;
+    }
+
+    std::lock_guard<std::mutex> lk(mutex);
+    while(!clusterings.empty() && clusterPoints + size > CACHE_MAX_CLUSTER_POINTS){
+        clusterPoints -= countPoints(clusterings.front().second);
+        clusterings.pop_front();
+    }
+    clusterings.emplace_back(key, clusters);
+    clusterPoints += size;
+}
+
+/**
+ * Looks up the final k-means centroids of the last clustering of a point set
+ * @param points Point set fingerprint
+ * @param centroids Output, set to the cached centroids if found
+ * @return Whether centroids were cached
+ */
+bool ResultCache::findCentroids(uint64_t points, std::vector<Coordinate>& centroids) {
+    std::lock_guard<std::mutex> lk(mutex);
+    auto it = this->centroids.find(points);
+    if(it == this->centroids.end()){
+        return false;
+    }
+    centroids = it->second;
+    return true;
+}
+
+void ResultCache::storeCentroids(uint64_t points, const std::vector<Coordinate>& centroids) {
+    if(centroids.size() > CACHE_MAX_CENTROID_POINTS){
+        return;
+    }
+
+    std::lock_guard<std::mutex> lk(mutex);
+    auto it = this->centroids.find(points);
+    if(it != this->centroids.end()){
+        centroidPoints -= it->second.size();
+    }else if(centroidPoints + centroids.size() > CACHE_MAX_CENTROID_POINTS){
+        // Centroids are cheap to recompute, start over rather than track their age
+        this->centroids.clear();
+        centroidPoints = 0;
+    }
+    this->centroids[points] = centroids;
+    centroidPoints += centroids.size();
+}
+
+/**
+ * Looks up the layers of a peeled point set
+ * @param members Membership fingerprint of the points peeled
+ * @param layers Output, set to the cached layers if found
+ * @return Whether the layers were cached
+ */
+bool ResultCache::findLayers(uint64_t members, std::vector<std::vector<Coordinate>>& layers) {
+    std::lock_guard<std::mutex> lk(mutex);
+    auto it = peels.find(members);
+    if(it == peels.end()){
+        return false;
+    }
+    layers = it->second;
+    return true;
+}
+
+void ResultCache::storeLayers(uint64_t members, const std::vector<std::vector<Coordinate>>& layers) {
+    size_t size = countPoints(layers);
+    if(size > CACHE_MAX_PEEL_POINTS){
+        return;
+    }
+
+    std::lock_guard<std::mutex> lk(mutex);
+    if(peels.find(members) != peels.end()){
+        return;
+    }
+
+    while(!peelOrder.empty() && peelPoints + size > CACHE_MAX_PEEL_POINTS){
+        auto oldest = peels.find(peelOrder.front());
+        peelPoints -= countPoints(oldest->second);
+        peels.erase(oldest);
+        peelOrder.pop_front();
+    }
+    peels.emplace(members, layers);
+    peelOrder.push_back(members);
+    peelPoints += size;
+}
+
+/**
+ * Hashes a point set, taking the order of the points into account
+ */
+uint64_t ResultCache::fingerprint(const std::vector<Coordinate>& points) {
+    uint64_t h = mix(points.size());
+    for(const Coordinate& c: points){
+        h = mix(h ^ (((uint64_t)(uint32_t)c.getX() << 32) | (uint32_t)c.getY()));
+    }
+    return h;
+}
+
+/**
+ * Hashes a point set regardless of the order of the points
+ */
+uint64_t ResultCache::membership(const std::vector<Coordinate>& points) {
+    uint64_t h = 0;
+    for(const Coordinate& c: points){
+        h += mix(((uint64_t)(uint32_t)c.getX() << 32) | (uint32_t)c.getY());
+    }
+    return mix(h ^ mix(points.size()));
+}
+
+/**
+ * Total number of points over all groups
+ */
+size_t ResultCache::countPoints(const std::vector<std::vector<Coordinate>>& groups) {
+    size_t n = 0;
+    for(auto& group: groups){
+        n += group.size();
+    }
+    return n;
+}
+
+/**
+ * splitmix64 finalizer
+ */
+uint64_t ResultCache::mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
@@ -0,0 +1,60 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <vector>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <cstdint>
+#include <unordered_map>
+#include "coordinate.h"
+
+// Budgets on the number of points held, a result larger than its budget is not cached
+#define CACHE_MAX_CLUSTER_POINTS (1 << 24)
+#define CACHE_MAX_CENTROID_POINTS (1 << 16)
+#define CACHE_MAX_PEEL_POINTS (1 << 24)
+
+/**
+ * Remembers clusterings and peels so unchanged work is not redone.
+ * Clusterings are keyed by an ordered fingerprint of the point set plus k, seed and method.
+ * Peels are keyed by an order independent fingerprint of the points peeled, so a cluster
+ * whose membership did not change is served from the cache whatever the clustering it came from.
+ * Final k-means centroids are kept per point set to warm start runs with a different k or iterations.
+ * Each kind of result is bounded by the total number of points it holds, oldest entries are evicted first.
+ * Safe to use from several threads.
+ */
+class ResultCache {
+public:
+    struct ClusterKey {
+        uint64_t points;
+        int k;
+        unsigned long seed;
+        std::string method;
+        bool operator==(const ClusterKey& other) const;
+    };
+
+    bool findClusters(const ClusterKey& key, std::vector<std::vector<Coordinate>>& clusters);
+    void storeClusters(const ClusterKey& key, const std::vector<std::vector<Coordinate>>& clusters);
+    bool findCentroids(uint64_t points, std::vector<Coordinate>& centroids);
+    void storeCentroids(uint64_t points, const std::vector<Coordinate>& centroids);
+    bool findLayers(uint64_t members, std::vector<std::vector<Coordinate>>& layers);
+    void storeLayers(uint64_t members, const std::vector<std::vector<Coordinate>>& layers);
+
+    static uint64_t fingerprint(const std::vector<Coordinate>& points);
+    static uint64_t membership(const std::vector<Coordinate>& points);
+private:
+    static uint64_t mix(uint64_t x);
+    static size_t countPoints(const std::vector<std::vector<Coordinate>>& groups);
+private:
+    std::mutex mutex;
+    std::deque<std::pair<ClusterKey, std::vector<std::vector<Coordinate>>>> clusterings;
+    std::unordered_map<uint64_t, std::vector<Coordinate>> centroids;
+    std::unordered_map<uint64_t, std::vector<std::vector<Coordinate>>> peels;
+    std::deque<uint64_t> peelOrder;
+    size_t clusterPoints = 0;
+    size_t centroidPoints = 0;
+    size_t peelPoints = 0;
+};
+
+
+#endif //RESULT_CACHE_H
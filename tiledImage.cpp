@@ -0,0 +1,273 @@
+#include "tiledImage.h"
+#include <iostream>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#ifdef KMEANS_PEEL_PNG
+#include <zlib.h>
+#endif
+
+#define PIXELS_PER_TILE (TILE_SIZE * TILE_SIZE)
+
+/**
+ * Creates an empty tiled canvas with width w and height h
+ * @param backingFile File to memory-map the tiles into, tiles are kept on the heap if empty
+ */
+TiledImage::TiledImage(int w, int h, const std::string& backingFile) {
+    this->imgWidth = w;
+    this->imgHeight = h;
+    this->tilesX = (w + TILE_SIZE - 1) / TILE_SIZE;
+    this->tilesY = (h + TILE_SIZE - 1) / TILE_SIZE;
+    this->allocatedTiles = 0;
+    this->fd = -1;
+    this->mapped = nullptr;
+    this->mappedSize = 0;
+
+    size_t nTiles = (size_t)tilesX * tilesY;
+    this->tiles.reset(new std::atomic<GlPixel*>[nTiles]);
+    for(size_t t = 0; t < nTiles; t++){
+        this->tiles[t] = nullptr;
+    }
+
+    if(backingFile.empty()){
+        return;
+    }
+
+    // The file is sized for every tile but stays sparse, only the pages of drawn tiles hit the disk
+    this->mappedSize = nTiles * PIXELS_PER_TILE * sizeof(GlPixel);
+    this->fd = open(backingFile.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(this->fd < 0 || ftruncate(this->fd, (off_t)this->mappedSize) != 0){
+        std::cerr << "Error: could not create tile file " << backingFile << ". Using memory instead." << std::endl;
+        if(this->fd >= 0){
+            close(this->fd);
+            this->fd = -1;
+        }
+        return;
+    }
+
+    void* addr = mmap(nullptr, this->mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+    if(addr == MAP_FAILED){
+        std::cerr << "Error: could not map tile file " << backingFile << ". Using memory instead." << std::endl;
+        close(this->fd);
+        this->fd = -1;
+        return;
+    }
+    this->mapped = (GlPixel*)addr;
+}
+
+TiledImage::~TiledImage() {
+    if(this->mapped != nullptr){
+        munmap(this->mapped, this->mappedSize);
+        close(this->fd);
+    }else{
+        for(size_t t = 0; t < (size_t)tilesX * tilesY; t++){
+            delete[] this->tiles[t].load();
+        }
+    }
+}
+
+/**
+ * Returns the tile at tile column tx and tile row ty, allocating it black on first use
+ */
+GlPixel* TiledImage::getTile(int tx, int ty) {
+    size_t t = (size_t)ty * tilesX + tx;
+
+    GlPixel* tile = this->tiles[t].load(std::memory_order_acquire);
+    if(tile != nullptr){
+        return tile;
+    }
+
+    std::lock_guard<std::mutex> lk(allocMutex);
+    tile = this->tiles[t].load(std::memory_order_relaxed);
+    if(tile == nullptr){
+        tile = this->mapped != nullptr ? this->mapped + t * PIXELS_PER_TILE : new GlPixel[PIXELS_PER_TILE];
+        std::memset((void*)tile, 0, PIXELS_PER_TILE * sizeof(GlPixel));
+        this->tiles[t].store(tile, std::memory_order_release);
+        this->allocatedTiles++;
+    }
+    return tile;
+}
+
+/**
+ * Sets a pixel at location x and y in the image with the given color channels
+ */
+void TiledImage::setPixel(int x, int y, int r, int g, int b) {
+    if(y >= this->imgHeight || y < 0 || x >= this->imgWidth || x < 0){
+        return;
+    }
+
+    int tx = x / TILE_SIZE, ty = y / TILE_SIZE;
+    GlPixel& p = getTile(tx, ty)[(y % TILE_SIZE) * TILE_SIZE + (x % TILE_SIZE)];
+
+    std::lock_guard<std::mutex> lk(tileLocks[(ty * tilesX + tx) % TILE_LOCK_STRIPES]);
+    p.r = r;
+    p.g = g;
+    p.b = b;
+}
+
+/**
+ * Sets len pixels of row y starting at x to the given color channels
+ */
+void TiledImage::setSpan(int x, int y, int len, int r, int g, int b) {
+    int x1 = std::min(x + len, this->imgWidth);
+    for(int i = std::max(x, 0); i < x1; i++){
+        setPixel(i, y, r, g, b);
+    }
+}
+
+/**
+ * Sets the whole image black by releasing every tile
+ */
+void TiledImage::clear() {
+    std::lock_guard<std::mutex> lk(allocMutex);
+    for(size_t t = 0; t < (size_t)tilesX * tilesY; t++){
+        GlPixel* tile = this->tiles[t].exchange(nullptr);
+        if(this->mapped == nullptr){
+            delete[] tile;
+        }
+    }
+    this->allocatedTiles = 0;
+}
+
+int TiledImage::getHeight() {
+    return this->imgHeight;
+}
+
+int TiledImage::getWidth() {
+    return this->imgWidth;
+}
+
+size_t TiledImage::getAllocatedTiles() {
+    return this->allocatedTiles;
+}
+
+/**
+ * Fills row with the RGB bytes of image row y, untouched tiles read as black
+ */
+void TiledImage::readRow(int y, std::vector<unsigned char>& row) {
+    row.assign((size_t)this->imgWidth * 3, 0);
+
+    int ty = y / TILE_SIZE;
+    for(int tx = 0; tx < tilesX; tx++){
+        GlPixel* tile = this->tiles[(size_t)ty * tilesX + tx].load(std::memory_order_acquire);
+        if(tile == nullptr){
+            continue;
+        }
+
+        GlPixel* src = tile + (y % TILE_SIZE) * TILE_SIZE;
+        int xEnd = std::min(TILE_SIZE, this->imgWidth - tx * TILE_SIZE);
+        unsigned char* dst = &row[(size_t)tx * TILE_SIZE * 3];
+        for(int x = 0; x < xEnd; x++){
+            *dst++ = src[x].r;
+            *dst++ = src[x].g;
+            *dst++ = src[x].b;
+        }
+    }
+}
+
+/**
+ * Streams the image to a binary PPM file one row at a time, top row first
+ * @param path File to write
+ * @return Whether the file was written
+ */
+bool TiledImage::writePpm(const std::string& path) {
+    std::ofstream out(path, std::ios::binary);
+    if(!out){
+        std::cerr << "Error: could not open " << path << std::endl;
+        return false;
+    }
+
+    out << "P6\n" << this->imgWidth << " " << this->imgHeight << "\n255\n";
+
+    std::vector<unsigned char> row;
+    for(int y = this->imgHeight - 1; y >= 0; y--){
+        readRow(y, row);
+        out.write((const char*)row.data(), (std::streamsize)row.size());
+    }
+
+    return (bool)out;
+}
+
+#ifdef KMEANS_PEEL_PNG
+static void writeBigEndian(std::ofstream& out, uint32_t value) {
+    unsigned char bytes[4] = {(unsigned char)(value >> 24), (unsigned char)(value >> 16), (unsigned char)(value >> 8), (unsigned char)value};
+    out.write((const char*)bytes, 4);
+}
+
+static void writeChunk(std::ofstream& out, const char* type, const unsigned char* data, size_t len) {
+    writeBigEndian(out, (uint32_t)len);
+    out.write(type, 4);
+    out.write((const char*)data, (std::streamsize)len);
+
+    uLong crc = crc32(0, (const Bytef*)type, 4);
+    if(len > 0){
+        crc = crc32(crc, data, (uInt)len);
+    }
+    writeBigEndian(out, (uint32_t)crc);
+}
+#endif
+
+/**
+ * Streams the image to an RGB PNG file, compressing one row at a time, top row first
+ * @param path File to write
+ * @return Whether the file was written
+ */
+bool TiledImage::writePng(const std::string& path) {
+#ifdef KMEANS_PEEL_PNG
+    std::ofstream out(path, std::ios::binary);
+    if(!out){
+        std::cerr << "Error: could not open " << path << std::endl;
+        return false;
+    }
+
+    const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    out.write((const char*)signature, 8);
+
+    unsigned char header[13] = {
+            (unsigned char)(imgWidth >> 24), (unsigned char)(imgWidth >> 16), (unsigned char)(imgWidth >> 8), (unsigned char)imgWidth,
+            (unsigned char)(imgHeight >> 24), (unsigned char)(imgHeight >> 16), (unsigned char)(imgHeight >> 8), (unsigned char)imgHeight,
+            8, 2, 0, 0, 0 // 8 bit RGB, deflate, no interlace
+    };
+    writeChunk(out, "IHDR", header, sizeof(header));
+
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    deflateInit(&zs, Z_DEFAULT_COMPRESSION);
+
+    std::vector<unsigned char> compressed(1 << 16);
+    std::vector<unsigned char> row;
+
+    for(int y = this->imgHeight; y >= 0; y--){
+        int flush = Z_NO_FLUSH;
+        if(y > 0){
+            readRow(y - 1, row);
+            row.insert(row.begin(), 0); // filter type none
+            zs.next_in = row.data();
+            zs.avail_in = (uInt)row.size();
+        }else{
+            flush = Z_FINISH;
+        }
+
+        int status;
+        do{
+            zs.next_out = compressed.data();
+            zs.avail_out = (uInt)compressed.size();
+            status = deflate(&zs, flush);
+
+            size_t produced = compressed.size() - zs.avail_out;
+            if(produced > 0){
+                writeChunk(out, "IDAT", compressed.data(), produced);
+            }
+        }while(zs.avail_out == 0 || (flush == Z_FINISH && status != Z_STREAM_END));
+    }
+    deflateEnd(&zs);
+
+    writeChunk(out, "IEND", nullptr, 0);
+    return (bool)out;
+#else
+    std::cerr << "Error: built without zlib, PNG output is unavailable. Write a .ppm instead." << std::endl;
+    return false;
+#endif
+}
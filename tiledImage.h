@@ -0,0 +1,53 @@
+#ifndef TILED_IMAGE_H
+#define TILED_IMAGE_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <fstream>
+#include "glPixel.h"
+#include "canvas.h"
+
+#define TILE_SIZE 256
+#define TILE_LOCK_STRIPES 64
+
+/**
+ * Canvas split into TILE_SIZE x TILE_SIZE tiles that are only allocated when first drawn on,
+ * so memory tracks the drawn area instead of the canvas size. Tiles can live on the heap or
+ * in a sparse memory-mapped file. Untouched tiles read as black.
+ */
+class TiledImage : public Canvas {
+public:
+    explicit TiledImage(int w, int h, const std::string& backingFile = "");
+    ~TiledImage() override;
+    void setPixel(int x, int y, int r, int g, int b) override;
+    void setSpan(int x, int y, int len, int r, int g, int b) override;
+    void clear() override;
+    int getHeight() override;
+    int getWidth() override;
+    size_t getAllocatedTiles();
+    bool writePpm(const std::string& path);
+    bool writePng(const std::string& path);
+private:
+    GlPixel* getTile(int tx, int ty);
+    void readRow(int y, std::vector<unsigned char>& row);
+private:
+    int imgWidth;
+    int imgHeight;
+    int tilesX;
+    int tilesY;
+    std::unique_ptr<std::atomic<GlPixel*>[]> tiles;
+    std::atomic<size_t> allocatedTiles;
+    std::mutex allocMutex;
+    std::mutex tileLocks[TILE_LOCK_STRIPES];
+
+    // Memory-mapped backing, unused when tiles are on the heap
+    int fd;
+    GlPixel* mapped;
+    size_t mappedSize;
+};
+
+
+#endif //TILED_IMAGE_H